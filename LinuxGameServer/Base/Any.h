@@ -4,6 +4,8 @@
 #include <typeinfo>
 #include <cstring>
 #include <string>
+#include <cstddef>
+#include <new>
 #include "MetaProgramming.h"
 #include "BaseException.h"
 
@@ -19,22 +21,78 @@ namespace Dynamic {
 }
 
 
-template <typename PlaceholderT>
+// Values whose holder fits in SMALL_OBJECT_SIZE bytes (vtable pointer
+// included) are stored inline in Any instead of on the heap.
+#ifndef SMALL_OBJECT_SIZE
+#define SMALL_OBJECT_SIZE 40
+#endif
+
+
+template <typename PlaceholderT, unsigned int SizeV = SMALL_OBJECT_SIZE>
 union Placeholder
 {
 public:
+	struct Size
+	{
+		static const unsigned int value = SizeV;
+	};
+
 	Placeholder()
 	{
+		erase();
+	}
+
+	void erase()
+	{
+		std::memset(holder, 0, sizeof(holder));
+	}
+
+	bool isEmpty() const
+	{
+		return !isLocal() && !pHolder;
+	}
+
+	bool isLocal() const
+	{
+		return holder[SizeV] != 0;
 	}
 
 	PlaceholderT* content() const
 	{
-		return pHolder;
+		if (isLocal())
+			return reinterpret_cast<PlaceholderT*>(holder);
+		else
+			return pHolder;
 	}
 
-private:
+	template <typename T, typename V>
+	void assign(const V& value)
+	{
+		if (sizeof(T) <= SizeV && alignof(T) <= alignof(std::max_align_t))
+		{
+			new (holder) T(value);
+			holder[SizeV] = 1;
+		}
+		else
+		{
+			pHolder = new T(value);
+			holder[SizeV] = 0;
+		}
+	}
 
+	void destroy()
+	{
+		if (isLocal())
+			content()->~PlaceholderT();
+		else
+			delete pHolder;
+		erase();
+	}
+
+private:
 	PlaceholderT* pHolder;
+	mutable unsigned char holder[SizeV + 1];
+	std::max_align_t aligner;
 
 	friend class Any;
 	friend class Dynamic::Var;
@@ -46,29 +104,42 @@ private:
 class Any
 {
 public:
-	Any() : _pHolder(0)
+	Any()
 	{
 	}
 
 	template <typename ValueType>
-	Any(const ValueType& value) :
-		_pHolder(new Holder<ValueType>(value))
+	Any(const ValueType& value)
 	{
+		_valueHolder.assign<Holder<ValueType>>(value);
 	}
 
-	Any(const Any& other) :
-		_pHolder(other._pHolder ? other._pHolder->clone() : 0)
+	Any(const Any& other)
 	{
+		if (!other.empty()) other.content()->clone(&_valueHolder);
 	}
 
 	~Any()
 	{
-		delete _pHolder;
+		_valueHolder.destroy();
 	}
 
 	Any& swap(Any& rhs)
 	{
-		std::swap(_pHolder, rhs._pHolder);
+		if (this == &rhs) return *this;
+
+		if (!_valueHolder.isLocal() && !rhs._valueHolder.isLocal())
+		{
+			std::swap(_valueHolder.pHolder, rhs._valueHolder.pHolder);
+		}
+		else
+		{
+			Any tmp(*this);
+			_valueHolder.destroy();
+			if (!rhs.empty()) rhs.content()->clone(&_valueHolder);
+			rhs._valueHolder.destroy();
+			if (!tmp.empty()) tmp.content()->clone(&rhs._valueHolder);
+		}
 		return *this;
 	}
 
@@ -87,12 +158,17 @@ public:
 
 	bool empty() const
 	{
-		return !_pHolder;
+		return _valueHolder.isEmpty();
+	}
+
+	bool local() const
+	{
+		return _valueHolder.isLocal();
 	}
 
 	const std::type_info& type() const
 	{
-		return _pHolder ? _pHolder->type() : typeid(void);
+		return empty() ? typeid(void) : content()->type();
 	}
 
 private:
@@ -102,7 +178,7 @@ private:
 		virtual ~ValueHolder() = default;
 
 		virtual const std::type_info& type() const = 0;
-		virtual ValueHolder* clone() const = 0;
+		virtual void clone(Placeholder<ValueHolder>* pPlaceholder) const = 0;
 	};
 
 	template <typename ValueType>
@@ -119,9 +195,9 @@ private:
 			return typeid(ValueType);
 		}
 
-		virtual ValueHolder* clone() const
+		virtual void clone(Placeholder<ValueHolder>* pPlaceholder) const
 		{
-			return new Holder(_held);
+			pPlaceholder->assign<Holder>(_held);
 		}
 
 		ValueType _held;
@@ -132,11 +208,11 @@ private:
 
 	ValueHolder* content() const
 	{
-		return _pHolder;
+		return _valueHolder.content();
 	}
 
 private:
-	ValueHolder* _pHolder;
+	Placeholder<ValueHolder> _valueHolder;
 
 	template <typename ValueType>
 	friend ValueType* AnyCast(Any*);
@@ -180,10 +256,10 @@ ValueType AnyCast(Any& operand)
 	if (!result)
 	{
 		std::string s = "RefAnyCast: Failed to convert between Any types ";
-		if (operand._pHolder)
+		if (!operand.empty())
 		{
 			s.append(1, '(');
-			s.append(operand._pHolder->type().name());
+			s.append(operand.type().name());
 			s.append(" => ");
 			s.append(typeid(ValueType).name());
 			s.append(1, ')');
@@ -210,10 +286,10 @@ const ValueType& RefAnyCast(const Any& operand)
 	if (!result)
 	{
 		std::string s = "RefAnyCast: Failed to convert between Any types ";
-		if (operand._pHolder)
+		if (!operand.empty())
 		{
 			s.append(1, '(');
-			s.append(operand._pHolder->type().name());
+			s.append(operand.type().name());
 			s.append(" => ");
 			s.append(typeid(ValueType).name());
 			s.append(1, ')');
@@ -231,10 +307,10 @@ ValueType& RefAnyCast(Any& operand)
 	if (!result)
 	{
 		std::string s = "RefAnyCast: Failed to convert between Any types ";
-		if (operand._pHolder)
+		if (!operand.empty())
 		{
 			s.append(1, '(');
-			s.append(operand._pHolder->type().name());
+			s.append(operand.type().name());
 			s.append(" => ");
 			s.append(typeid(ValueType).name());
 			s.append(1, ')');
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <atomic>
+
+
+template <class TArgs>
+class BasicEvent
+{
+public:
+	using Delegate = std::function<void(const void*, TArgs&)>;
+
+	BasicEvent() :
+		_nextId(1),
+		_enabled(true)
+	{
+	}
+
+	int add(const Delegate& delegate)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		DelegateVecPtr pDelegates(new DelegateVec(_pDelegates ? *_pDelegates : DelegateVec()));
+		pDelegates->push_back(std::make_pair(_nextId, delegate));
+		std::atomic_store(&_pDelegates, DelegateVecConstPtr(pDelegates));
+		return _nextId++;
+	}
+
+	void remove(int id)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		if (!_pDelegates) return;
+		DelegateVecPtr pDelegates(new DelegateVec);
+		for (const auto& d : *_pDelegates)
+		{
+			if (d.first != id) pDelegates->push_back(d);
+		}
+		std::atomic_store(&_pDelegates, DelegateVecConstPtr(pDelegates));
+	}
+
+	void clear()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		std::atomic_store(&_pDelegates, DelegateVecConstPtr());
+	}
+
+	void notify(const void* pSender, TArgs& args)
+	{
+		if (!_enabled) return;
+		DelegateVecConstPtr pDelegates = std::atomic_load(&_pDelegates);
+		if (!pDelegates) return;
+		for (const auto& d : *pDelegates)
+		{
+			d.second(pSender, args);
+		}
+	}
+
+	void operator () (const void* pSender, TArgs& args)
+	{
+		notify(pSender, args);
+	}
+
+	void enable()
+	{
+		_enabled = true;
+	}
+
+	void disable()
+	{
+		_enabled = false;
+	}
+
+	bool isEnabled() const
+	{
+		return _enabled;
+	}
+
+	bool empty() const
+	{
+		DelegateVecConstPtr pDelegates = std::atomic_load(&_pDelegates);
+		return !pDelegates || pDelegates->empty();
+	}
+
+private:
+	using DelegateVec = std::vector<std::pair<int, Delegate>>;
+	using DelegateVecPtr = std::shared_ptr<DelegateVec>;
+	using DelegateVecConstPtr = std::shared_ptr<const DelegateVec>;
+
+	BasicEvent(const BasicEvent&);
+	BasicEvent& operator = (const BasicEvent&);
+
+	DelegateVecConstPtr _pDelegates;
+	int                 _nextId;
+	std::atomic_bool    _enabled;
+	std::mutex          _mutex;
+};
@@ -0,0 +1,105 @@
+#include "BiasedRefCountedObject.h"
+#include <mutex>
+#include <vector>
+
+
+struct BiasedRefCountedObject::Queue
+{
+	std::mutex mutex;
+	std::vector<const BiasedRefCountedObject*> objects;
+};
+
+
+thread_local BiasedRefCountedObject::Queue* BiasedRefCountedObject::_pLocalQueue = nullptr;
+
+
+BiasedRefCountedObject::BiasedRefCountedObject() :
+	_biased(1),
+	_merged(false),
+	_shared(0)
+{
+	// Queues live as long as the process so objects never outlive theirs.
+	if (!_pLocalQueue) _pLocalQueue = new Queue;
+	_pQueue = _pLocalQueue;
+}
+
+
+BiasedRefCountedObject::~BiasedRefCountedObject()
+{
+}
+
+
+void BiasedRefCountedObject::merge() const noexcept
+{
+	_merged = true;
+	Int64 old = _shared.fetch_or(MERGED, std::memory_order_acq_rel);
+	if ((old >> 2) == 0 && !(old & QUEUED)) destroy();
+}
+
+
+void BiasedRefCountedObject::releaseShared() const noexcept
+{
+	Int64 old = _shared.load(std::memory_order_relaxed);
+	Int64 value;
+	bool enqueue;
+	do
+	{
+		value = old - ONE;
+		enqueue = (value >> 2) < 0 && !(value & (QUEUED | MERGED));
+		if (enqueue) value |= QUEUED;
+	}
+	while (!_shared.compare_exchange_weak(old, value, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+	if (enqueue)
+	{
+		std::unique_lock<std::mutex> lock(_pQueue->mutex);
+		_pQueue->objects.push_back(this);
+	}
+	else if ((value >> 2) == 0 && (value & (QUEUED | MERGED)) == MERGED)
+	{
+		destroy();
+	}
+}
+
+
+void BiasedRefCountedObject::destroy() const noexcept
+{
+	try
+	{
+		delete this;
+	}
+	catch (...)
+	{
+		UNEXPECTED();
+	}
+}
+
+
+std::size_t BiasedRefCountedObject::processQueue()
+{
+	if (!_pLocalQueue) return 0;
+
+	std::vector<const BiasedRefCountedObject*> objects;
+	{
+		std::unique_lock<std::mutex> lock(_pLocalQueue->mutex);
+		objects.swap(_pLocalQueue->objects);
+	}
+
+	std::size_t destroyed = 0;
+	for (const BiasedRefCountedObject* pObj : objects)
+	{
+		if (!pObj->_merged)
+		{
+			pObj->_merged = true;
+			pObj->_shared.fetch_add(pObj->_biased * static_cast<Int64>(ONE) + MERGED, std::memory_order_acq_rel);
+			pObj->_biased = 0;
+		}
+		Int64 old = pObj->_shared.fetch_and(~static_cast<Int64>(QUEUED), std::memory_order_acq_rel);
+		if ((old >> 2) == 0)
+		{
+			pObj->destroy();
+			++destroyed;
+		}
+	}
+	return destroyed;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Types.h"
+#include "Bugcheck.h"
+#include <atomic>
+#include <cstddef>
+
+
+// Reference counted object with biased counting: the creating thread (the
+// owner) counts with a plain int, other threads use an atomic counter. When
+// the owner drops its last reference the two counters are merged and the
+// object behaves like a RefCountedObject from then on.
+//
+// If another thread releases a reference the owner took, the shared count
+// goes negative and the object is queued for the owner, which must call
+// processQueue() periodically (once per frame is enough); until then such
+// objects are not reclaimed.
+class BiasedRefCountedObject
+{
+public:
+	BiasedRefCountedObject();
+
+	void duplicate() const;
+
+	void release() const noexcept;
+
+	int referenceCount() const;
+
+	bool isOwner() const;
+
+	static std::size_t processQueue();
+
+protected:
+	virtual ~BiasedRefCountedObject();
+
+private:
+	struct Queue;
+
+	enum
+	{
+		MERGED = 1,
+		QUEUED = 2,
+		ONE    = 4
+	};
+
+	BiasedRefCountedObject(const BiasedRefCountedObject&);
+	BiasedRefCountedObject& operator = (const BiasedRefCountedObject&);
+
+	void merge() const noexcept;
+	void releaseShared() const noexcept;
+	void destroy() const noexcept;
+
+	Queue*                     _pQueue;
+	mutable int                _biased;
+	mutable bool               _merged;
+	mutable std::atomic<Int64> _shared;
+
+	static thread_local Queue* _pLocalQueue;
+};
+
+
+inline bool BiasedRefCountedObject::isOwner() const
+{
+	return _pQueue == _pLocalQueue;
+}
+
+
+inline int BiasedRefCountedObject::referenceCount() const
+{
+	Int64 shared = _shared.load(std::memory_order_relaxed) >> 2;
+	return static_cast<int>(isOwner() && !_merged ? _biased + shared : shared);
+}
+
+
+inline void BiasedRefCountedObject::duplicate() const
+{
+	if (isOwner() && !_merged)
+		++_biased;
+	else
+		_shared.fetch_add(ONE, std::memory_order_relaxed);
+}
+
+
+inline void BiasedRefCountedObject::release() const noexcept
+{
+	if (isOwner() && !_merged)
+	{
+		if (--_biased == 0) merge();
+	}
+	else releaseShared();
+}
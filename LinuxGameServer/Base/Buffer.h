@@ -13,31 +13,39 @@
 
 #include <memory>
 #include <cstring>
+#include <new>
+#include <type_traits>
 #include "Bugcheck.h"
+#include "MirroredMemory.h"
 
 
+/// Ϊ [begin(), end()), дΪ [end(), end() + available()).
+/// ģʽ»ӳ䵽ͬһڴĵַ, дԽβʱ
+/// Ȼ, Ҫֶд.
 template <class T>
 class Buffer
 {
+	static_assert(std::is_trivially_copyable<T>::value, "Buffer requires a trivially copyable type");
+
 public:
-	Buffer(std::size_t size)
-		: m_capacity(size)
-		, m_size(0)
+	/// @param [in] size ʼݻ
+	/// @param [in] ring Ƿʹûģʽ(ݻᰴҳС)
+	Buffer(std::size_t size, bool ring = false)
+		: m_capacity(0)
+		, m_readPos(0)
+		, m_writePos(0)
 		, m_ptr(nullptr)
+		, m_ring(ring)
 	{
 		if (size > 0)
 		{
-			m_ptr = new T[size];
+			allocate(size);
 		}
 	}
 
 	~Buffer()
 	{
-		if (m_ptr)
-		{
-			delete[] m_ptr;
-			m_ptr = nullptr;
-		}
+		deallocate();
 	}
 
 	/// ı䵱ǰBufferĴСΪnewSize
@@ -48,19 +56,12 @@ public:
 		ASSERT(newSize > 0 );
 		if (newSize <= 0) return;
 
+		if (!preserveContent) clear();
+
 		// еĻѾ,ǾͲ·.
 		if (newSize <= m_capacity) return;
 
-		T* ptr = new T[newSize];
-		ASSERT(ptr);
-		if (preserveContent)
-		{
-			std::size_t n = newSize > m_capacity ? m_capacity : newSize;
-			if (m_ptr) std::memcpy(ptr, m_ptr, n);
-		}
-		if (m_ptr) delete [] m_ptr;
-		m_ptr  = ptr;
-		m_capacity = newSize;
+		reallocate(newSize);
 	}
 
 	/// ɵԪ
@@ -72,62 +73,112 @@ public:
 	/// ݴС
 	std::size_t size() const
 	{
-		return m_size;
+		return m_writePos - m_readPos;
+	}
+
+	/// ݼдԪ
+	std::size_t available() const
+	{
+		return m_ring ? m_capacity - size() : m_capacity - m_writePos;
+	}
+
+	bool empty() const
+	{
+		return m_readPos == m_writePos;
+	}
+
+	bool isRing() const
+	{
+		return m_ring;
 	}
 
 	/// ʼָ
 	T* begin()
 	{
-		return m_ptr;
+		return m_ptr ? m_ptr + m_readPos : 0;
 	}
 	const T* begin() const
 	{
-		return m_ptr;
+		return m_ptr ? m_ptr + m_readPos : 0;
 	}
 
 	/// βָ
 	T* end()
 	{
-		if (m_ptr == 0) return 0;
-		return m_ptr + m_size;
+		return m_ptr ? m_ptr + m_writePos : 0;
 	}
 	const T* end() const
 	{
-		if (m_ptr == 0) return 0;
-		return m_ptr + m_size;
+		return m_ptr ? m_ptr + m_writePos : 0;
 	}
 
 	const T& operator [] (std::size_t index) const
 	{
-		ASSERT(index >= 0 && index < m_capacity);
-		if (m_ptr == 0) return 0;
-
-		return m_ptr[index];
+		ASSERT(m_ptr && index < m_capacity);
+		return begin()[index];
 	}
 	T& operator [] (std::size_t index)
 	{
-		ASSERT(index >= 0 && index < m_capacity);
-		if (m_ptr == 0) return 0;
+		ASSERT(m_ptr && index < m_capacity);
+		return begin()[index];
+	}
+
+	/// ֤nԪصдռ, дλ, дcommit(n).
+	/// ռ䲻ʱȰƵͷ, Բٰ.
+	T* prepare(std::size_t n)
+	{
+		if (available() < n)
+		{
+			std::size_t required = size() + n;
+			if (!m_ring && required <= m_capacity)
+				compact();
+			else
+				reallocate(required > 2 * m_capacity ? required : 2 * m_capacity);
+		}
+		return end();
+	}
+
+	/// ȷprepare()صĿռдnԪ
+	void commit(std::size_t n)
+	{
+		ASSERT(n <= available());
+		m_writePos += n;
+	}
+
+	/// ͷnԪ
+	void consume(std::size_t n)
+	{
+		ASSERT(n <= size());
+		m_readPos += n;
+		if (m_readPos == m_writePos)
+		{
+			m_readPos = m_writePos = 0;
+		}
+		else if (m_ring && m_readPos >= m_capacity)
+		{
+			m_readPos -= m_capacity;
+			m_writePos -= m_capacity;
+		}
+	}
 
-		return m_ptr[index];
+	void append(const T* pVals, std::size_t nSize)
+	{
+		if (nSize == 0) return;
+		std::memcpy(prepare(nSize), pVals, nSize * sizeof(T));
+		commit(nSize);
 	}
 
 	void setData(const T* pVals, std::size_t nSize)
 	{
 		ASSERT(nSize);
 		if (nSize <= 0) return;
-		if (nSize > capacity()) resize(nSize, false);
-		std::memcpy(m_ptr, pVals, nSize);
-		m_size = nSize;
+		clear();
+		append(pVals, nSize);
 	}
 
 	void clear()
 	{
-		if (m_ptr)
-		{
-			std::memset(m_ptr, 0, m_capacity);
-		}
-		m_size = 0;
+		m_readPos = m_writePos = 0;
 	}
 
 private:
@@ -135,7 +186,74 @@ private:
 	Buffer(const Buffer&);
 	Buffer& operator = (const Buffer&);
 
+	void allocate(std::size_t size)
+	{
+		if (m_ring)
+		{
+			std::size_t bytes = MirroredMemory::roundUp(size * sizeof(T));
+			ASSERT(bytes % sizeof(T) == 0);
+			m_ptr = reinterpret_cast<T*>(MirroredMemory::map(bytes));
+			m_capacity = bytes / sizeof(T);
+		}
+		else
+		{
+			m_ptr = static_cast<T*>(::operator new(size * sizeof(T)));
+			m_capacity = size;
+		}
+	}
+
+	void deallocate()
+	{
+		if (m_ptr)
+		{
+			if (m_ring)
+				MirroredMemory::unmap(reinterpret_cast<char*>(m_ptr), m_capacity * sizeof(T));
+			else
+				::operator delete(m_ptr);
+			m_ptr = nullptr;
+		}
+	}
+
+	void reallocate(std::size_t newSize)
+	{
+		T* ptr = m_ptr;
+		std::size_t capacity = m_capacity;
+		std::size_t n = size();
+		std::size_t readPos = m_readPos;
+
+		m_ptr = nullptr;
+		try
+		{
+			allocate(newSize);
+		}
+		catch (...)
+		{
+			m_ptr = ptr;
+			m_capacity = capacity;
+			throw;
+		}
+		if (n) std::memcpy(m_ptr, ptr + readPos, n * sizeof(T));
+		m_readPos = 0;
+		m_writePos = n;
+
+		std::swap(ptr, m_ptr);
+		std::swap(capacity, m_capacity);
+		deallocate();
+		m_ptr = ptr;
+		m_capacity = capacity;
+	}
+
+	void compact()
+	{
+		std::size_t n = size();
+		if (n) std::memmove(m_ptr, m_ptr + m_readPos, n * sizeof(T));
+		m_readPos = 0;
+		m_writePos = n;
+	}
+
 	std::size_t	m_capacity;	///< ݻ
-	std::size_t	m_size;		///< ݴС
+	std::size_t	m_readPos;	///< ʼλ
+	std::size_t	m_writePos;	///< ݽλ
 	T*			m_ptr;		///< ָ
+	bool		m_ring;		///< ģʽ
 };
@@ -0,0 +1,107 @@
+#include "Clock.h"
+#include <algorithm>
+#include <mutex>
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
+
+Clock::Tsc                Clock::s_tsc = {0, 0, 0, 0};
+std::atomic<bool>         Clock::s_tscReady(false);
+std::atomic<Int64>        Clock::s_coarseMonotonic(Clock::monotonicNanoseconds() / 1000);
+std::atomic<Int64>        Clock::s_coarseRealtime(Clock::realtimeNanoseconds() / 1000);
+
+
+Clock::Clock()
+{
+	update();
+}
+
+
+Clock::Clock(ClockVal tv)
+{
+	m_clock = tv;
+}
+
+
+Clock::Clock(const Clock& other)
+{
+	m_clock = other.m_clock;
+}
+
+
+Clock::~Clock()
+{
+}
+
+
+Clock& Clock::operator = (const Clock& other)
+{
+	m_clock = other.m_clock;
+	return *this;
+}
+
+
+Clock& Clock::operator = (ClockVal tv)
+{
+	m_clock = tv;
+	return *this;
+}
+
+
+void Clock::swap(Clock& clock)
+{
+	std::swap(m_clock, clock.m_clock);
+}
+
+
+void Clock::tick()
+{
+	s_coarseMonotonic.store(monotonicNanoseconds() / 1000, std::memory_order_relaxed);
+	s_coarseRealtime.store(realtimeNanoseconds() / 1000, std::memory_order_relaxed);
+}
+
+
+bool Clock::calibrateTsc()
+{
+#if defined(__x86_64__)
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (hasTsc()) return true;
+
+	// Only an invariant TSC ticks at a constant rate across P-states and cores.
+	unsigned eax, ebx, ecx, edx;
+	if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1u << 8)))
+		return false;
+
+	// Bracket each clock_gettime() between two TSC reads and take the midpoint.
+	UInt64 c0 = __rdtsc();
+	Int64  t0 = monotonicNanoseconds();
+	c0 = (c0 + __rdtsc()) / 2;
+
+	Int64  t1;
+	do
+	{
+		t1 = monotonicNanoseconds();
+	}
+	while (t1 - t0 < 20000000);
+
+	UInt64 c1 = __rdtsc();
+	t1 = monotonicNanoseconds();
+	c1 = (c1 + __rdtsc()) / 2;
+
+	if (c1 <= c0) return false;
+
+	Tsc tsc;
+	tsc.shift = 32;
+	tsc.mult  = UInt64(((unsigned __int128)(t1 - t0) << tsc.shift) / (c1 - c0));
+	tsc.base  = c1;
+	tsc.baseNanoseconds = t1;
+	s_tsc = tsc;
+	s_tscReady.store(true, std::memory_order_release);
+	return true;
+#else
+	return false;
+#endif
+}
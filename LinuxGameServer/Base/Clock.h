@@ -0,0 +1,262 @@
+#pragma once
+
+#include "Types.h"
+#include "Timestamp.h"
+#include <atomic>
+#include <ctime>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+
+// Monotonic clock value with microsecond resolution. Unlike Timestamp it
+// never jumps when the wall clock is adjusted, so use it for measuring
+// intervals and timeouts.
+//
+// The static functions expose the underlying sources:
+//  - monotonicNanoseconds()/realtimeNanoseconds() read clock_gettime(),
+//    which glibc serves from the vDSO without entering the kernel.
+//  - tscNanoseconds() scales the CPU time stamp counter once
+//    calibrateTsc() has succeeded (invariant TSC only), falling back to
+//    the monotonic clock otherwise. The scale is measured once, over
+//    20 ms, so the result slowly drifts away from CLOCK_MONOTONIC (NTP
+//    slewing is not followed either). Only subtract tscNanoseconds()
+//    values from each other; never mix them with monotonicNanoseconds()
+//    or Clock values.
+//  - coarse() and coarseTimestamp() return values cached by the last call
+//    to tick(). Every IServerTimer calls tick() before it dispatches
+//    OnTimer(), so they are as fresh as the latest timer callback. A
+//    process without a running server timer must call tick() itself;
+//    otherwise the values stay at program start.
+class Clock
+{
+public:
+	typedef Int64 ClockVal;		///< monotonic time in microseconds
+	typedef Int64 ClockDiff;	///< difference in microseconds
+
+	Clock();
+	Clock(ClockVal tv);
+	Clock(const Clock& other);
+	~Clock();
+
+	Clock& operator = (const Clock& other);
+	Clock& operator = (ClockVal tv);
+
+	void swap(Clock& clock);
+
+	void update();
+
+	bool operator == (const Clock& ts) const;
+	bool operator != (const Clock& ts) const;
+	bool operator >  (const Clock& ts) const;
+	bool operator >= (const Clock& ts) const;
+	bool operator <  (const Clock& ts) const;
+	bool operator <= (const Clock& ts) const;
+
+	Clock     operator +  (ClockDiff d) const;
+	Clock     operator -  (ClockDiff d) const;
+	ClockDiff operator -  (const Clock& ts) const;
+	Clock&    operator += (ClockDiff d);
+	Clock&    operator -= (ClockDiff d);
+
+	ClockVal microseconds() const;
+
+	ClockDiff elapsed() const;
+
+	bool isElapsed(ClockDiff interval) const;
+
+public:
+	static ClockVal resolution();
+
+	static Int64 monotonicNanoseconds();
+
+	static Int64 realtimeNanoseconds();
+
+	static bool calibrateTsc();
+
+	static bool hasTsc();
+
+	static Int64 tscNanoseconds();
+
+	static void tick();
+
+	static Clock coarse();
+
+	static Timestamp coarseTimestamp();
+
+private:
+	static Int64 readClock(clockid_t id);
+
+	struct Tsc
+	{
+		UInt64 base;
+		Int64  baseNanoseconds;
+		UInt64 mult;
+		int    shift;
+	};
+
+	static Tsc                s_tsc;
+	static std::atomic<bool>  s_tscReady;
+	static std::atomic<Int64> s_coarseMonotonic;
+	static std::atomic<Int64> s_coarseRealtime;
+
+	ClockVal m_clock;
+};
+
+
+inline bool Clock::operator == (const Clock& ts) const
+{
+	return m_clock == ts.m_clock;
+}
+
+
+inline bool Clock::operator != (const Clock& ts) const
+{
+	return m_clock != ts.m_clock;
+}
+
+
+inline bool Clock::operator >  (const Clock& ts) const
+{
+	return m_clock > ts.m_clock;
+}
+
+
+inline bool Clock::operator >= (const Clock& ts) const
+{
+	return m_clock >= ts.m_clock;
+}
+
+
+inline bool Clock::operator <  (const Clock& ts) const
+{
+	return m_clock < ts.m_clock;
+}
+
+
+inline bool Clock::operator <= (const Clock& ts) const
+{
+	return m_clock <= ts.m_clock;
+}
+
+
+inline Clock Clock::operator + (Clock::ClockDiff d) const
+{
+	return Clock(m_clock + d);
+}
+
+
+inline Clock Clock::operator - (Clock::ClockDiff d) const
+{
+	return Clock(m_clock - d);
+}
+
+
+inline Clock::ClockDiff Clock::operator - (const Clock& ts) const
+{
+	return m_clock - ts.m_clock;
+}
+
+
+inline Clock& Clock::operator += (Clock::ClockDiff d)
+{
+	m_clock += d;
+	return *this;
+}
+
+
+inline Clock& Clock::operator -= (Clock::ClockDiff d)
+{
+	m_clock -= d;
+	return *this;
+}
+
+
+inline Clock::ClockVal Clock::microseconds() const
+{
+	return m_clock;
+}
+
+
+inline void Clock::update()
+{
+	m_clock = monotonicNanoseconds() / 1000;
+}
+
+
+inline Clock::ClockDiff Clock::elapsed() const
+{
+	Clock now;
+	return now - *this;
+}
+
+
+inline bool Clock::isElapsed(Clock::ClockDiff interval) const
+{
+	Clock now;
+	Clock::ClockDiff diff = now - *this;
+	return diff >= interval;
+}
+
+
+inline Clock::ClockVal Clock::resolution()
+{
+	return 1000000;
+}
+
+
+inline Int64 Clock::monotonicNanoseconds()
+{
+	return readClock(CLOCK_MONOTONIC);
+}
+
+
+inline Int64 Clock::realtimeNanoseconds()
+{
+	return readClock(CLOCK_REALTIME);
+}
+
+
+inline Int64 Clock::readClock(clockid_t id)
+{
+	struct timespec ts;
+	::clock_gettime(id, &ts);
+	return Int64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+
+inline bool Clock::hasTsc()
+{
+	return s_tscReady.load(std::memory_order_acquire);
+}
+
+
+inline Int64 Clock::tscNanoseconds()
+{
+#if defined(__x86_64__)
+	if (hasTsc())
+	{
+		UInt64 delta = __rdtsc() - s_tsc.base;
+		return s_tsc.baseNanoseconds + Int64((unsigned __int128)delta * s_tsc.mult >> s_tsc.shift);
+	}
+#endif
+	return monotonicNanoseconds();
+}
+
+
+inline Clock Clock::coarse()
+{
+	return Clock(s_coarseMonotonic.load(std::memory_order_relaxed));
+}
+
+
+inline Timestamp Clock::coarseTimestamp()
+{
+	return Timestamp(s_coarseRealtime.load(std::memory_order_relaxed));
+}
+
+
+inline void swap(Clock& s1, Clock& s2)
+{
+	s1.swap(s2);
+}
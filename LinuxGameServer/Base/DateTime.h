@@ -144,6 +144,8 @@ private:
 	short _second;
 	short _millisecond;
 	short _microsecond;
+
+	friend class DateTimeCache;
 };
 
 
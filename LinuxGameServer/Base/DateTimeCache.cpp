@@ -0,0 +1,57 @@
+#include "DateTimeCache.h"
+
+
+namespace
+{
+	// 100 ns units, as used by Timestamp::UtcTimeVal
+	const Timestamp::UtcTimeVal UTC_MINUTE = 600000000LL;
+	const Timestamp::UtcTimeVal UTC_HOUR   = 60 * UTC_MINUTE;
+	const Timestamp::UtcTimeVal UTC_DAY    = 24 * UTC_HOUR;
+}
+
+
+DateTimeCache::DateTimeCache():
+	_dateTime(1582, 10, 15),
+	_dayStart(0),
+	_hourStart(0)
+{
+}
+
+
+const DateTime& DateTimeCache::convert(Timestamp::UtcTimeVal utcTime)
+{
+	Timestamp::UtcTimeVal offset = utcTime - _hourStart;
+	if (offset < 0 || offset >= UTC_HOUR)
+	{
+		offset = utcTime - _dayStart;
+		if (offset < 0 || offset >= UTC_DAY)
+		{
+			computeDay(utcTime);
+			offset = utcTime - _dayStart;
+		}
+		_dateTime._hour = short(offset / UTC_HOUR);
+		_hourStart = _dayStart + _dateTime._hour * UTC_HOUR;
+		offset -= _hourStart - _dayStart;
+	}
+
+	Timestamp::UtcTimeVal micros = offset / 10;
+	_dateTime._minute      = short(offset / UTC_MINUTE);
+	micros                -= _dateTime._minute * Timespan::MINUTES;
+	_dateTime._second      = short(micros / Timespan::SECONDS);
+	micros                -= _dateTime._second * Timespan::SECONDS;
+	_dateTime._millisecond = short(micros / 1000);
+	_dateTime._microsecond = short(micros % 1000);
+	_dateTime._utcTime     = utcTime;
+	return _dateTime;
+}
+
+
+void DateTimeCache::computeDay(Timestamp::UtcTimeVal utcTime)
+{
+	Timestamp::UtcTimeVal day = utcTime / UTC_DAY;
+	if (utcTime % UTC_DAY < 0) --day;
+	_dayStart = day * UTC_DAY;
+
+	DateTime midnight(_dayStart, 0);
+	_dateTime = midnight;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "DateTime.h"
+
+
+// Converts a stream of timestamps to DateTime, reusing the calendar date
+// of the previous conversion. Only a timestamp outside the cached day goes
+// through DateTime's Julian day computation; within the same day the time
+// fields are derived with integer arithmetic, and within the same hour only
+// the minute and below are recomputed.
+//
+// Not thread safe: use one cache per thread or per formatter.
+class DateTimeCache
+{
+public:
+	DateTimeCache();
+
+	// Returns the broken down time of timestamp shifted by tzd seconds.
+	// The reference stays valid until the next call.
+	const DateTime& convert(const Timestamp& timestamp, int tzd = 0);
+
+	const DateTime& convert(Timestamp::UtcTimeVal utcTime);
+
+private:
+	DateTimeCache(const DateTimeCache&);
+	DateTimeCache& operator = (const DateTimeCache&);
+
+	void computeDay(Timestamp::UtcTimeVal utcTime);
+
+	DateTime              _dateTime;
+	Timestamp::UtcTimeVal _dayStart;
+	Timestamp::UtcTimeVal _hourStart;
+};
+
+
+//
+// inlines
+//
+inline const DateTime& DateTimeCache::convert(const Timestamp& timestamp, int tzd)
+{
+	return convert(timestamp.utcTime() + Timestamp::UtcTimeVal(tzd) * 10 * Timespan::SECONDS);
+}
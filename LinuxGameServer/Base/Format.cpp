@@ -4,6 +4,7 @@
 #include <sstream>
 #include <locale>
 #include <cstddef>
+#include <cstdio>
 
 namespace
 {
@@ -274,3 +275,110 @@ void format(std::string& result, const std::string& fmt, const std::vector<Any>&
 		}
 	}
 }
+
+
+void FormatWriter::appendInteger(std::string& result, const FormatSpec& spec, UInt64 magnitude, bool negative)
+{
+	static const char lower[] = "0123456789abcdef";
+	static const char upper[] = "0123456789ABCDEF";
+
+	const char* digits = spec.type == 'X' ? upper : lower;
+	unsigned base = 10;
+	if (spec.type == 'x' || spec.type == 'X') base = 16;
+	else if (spec.type == 'o') base = 8;
+
+	char buffer[24];
+	char* end = buffer + sizeof(buffer);
+	char* begin = end;
+	do
+	{
+		*--begin = digits[magnitude % base];
+		magnitude /= base;
+	}
+	while (magnitude);
+
+	char prefix[2];
+	int prefixLength = 0;
+	if (negative) prefix[prefixLength++] = '-';
+	else if ((spec.flags & FormatSpec::FLAG_PLUS) && base == 10) prefix[prefixLength++] = '+';
+	if ((spec.flags & FormatSpec::FLAG_ALT) && *begin != '0')
+	{
+		if (base == 16)
+		{
+			prefix[prefixLength++] = '0';
+			prefix[prefixLength++] = spec.type;
+		}
+		else if (base == 8) *--begin = '0';
+	}
+
+	int length = prefixLength + static_cast<int>(end - begin);
+	int padding = spec.width > length ? spec.width - length : 0;
+	if (spec.flags & FormatSpec::FLAG_LEFT)
+	{
+		result.append(prefix, prefixLength);
+		result.append(begin, end);
+		result.append(padding, ' ');
+	}
+	else if (spec.flags & FormatSpec::FLAG_ZERO)
+	{
+		result.append(prefix, prefixLength);
+		result.append(padding, '0');
+		result.append(begin, end);
+	}
+	else
+	{
+		result.append(padding, ' ');
+		result.append(prefix, prefixLength);
+		result.append(begin, end);
+	}
+}
+
+
+void FormatWriter::appendFloat(std::string& result, const FormatSpec& spec, double value)
+{
+	char fmt[16];
+	char* p = fmt;
+	*p++ = '%';
+	if (spec.flags & FormatSpec::FLAG_LEFT) *p++ = '-';
+	if (spec.flags & FormatSpec::FLAG_PLUS) *p++ = '+';
+	if (spec.flags & FormatSpec::FLAG_ZERO) *p++ = '0';
+	if (spec.flags & FormatSpec::FLAG_ALT)  *p++ = '#';
+	*p++ = '*';
+	*p++ = '.';
+	*p++ = '*';
+	*p++ = spec.type;
+	*p = 0;
+
+	int precision = spec.precision < 0 ? 6 : spec.precision;
+	char buffer[64];
+	int n = std::snprintf(buffer, sizeof(buffer), fmt, spec.width, precision, value);
+	if (n < 0) return;
+	if (n < static_cast<int>(sizeof(buffer)))
+	{
+		result.append(buffer, n);
+	}
+	else
+	{
+		std::size_t pos = result.size();
+		result.resize(pos + n + 1);
+		std::snprintf(&result[pos], n + 1, fmt, spec.width, precision, value);
+		result.resize(pos + n);
+	}
+}
+
+
+void FormatWriter::appendString(std::string& result, const FormatSpec& spec, const char* str, std::size_t length)
+{
+	std::size_t width = spec.width > 0 ? static_cast<std::size_t>(spec.width) : 0;
+	std::size_t padding = width > length ? width - length : 0;
+	if (spec.flags & FormatSpec::FLAG_LEFT)
+	{
+		result.append(str, length);
+		result.append(padding, ' ');
+	}
+	else
+	{
+		result.append(padding, (spec.flags & FormatSpec::FLAG_ZERO) ? '0' : ' ');
+		result.append(str, length);
+	}
+}
@@ -1,10 +1,15 @@
 #pragma once
 
 #include "Any.h"
+#include "Types.h"
 #include <vector>
 #include <type_traits>
 #include <any>
 #include <string>
+#include <string_view>
+#include <array>
+#include <tuple>
+#include <utility>
 
 std::string format(const std::string& fmt, const Any& value);
 
@@ -67,3 +72,369 @@ template <
 	format(result, fmt, values);
 	return result;
 }
+
+
+//
+// Compile-time parsed format strings.
+//
+// FMT("...") turns a string literal into a distinct type whose placeholders
+// are parsed by the compiler, so format(FMT("%s=%d"), name, value) appends
+// each argument according to its static type without building a
+// std::vector<Any>. The placeholder syntax is the same as above; argument
+// count and conversion/type mismatches are reported by static_assert.
+//
+
+struct FormatLiteral
+{
+};
+
+
+#define FMT(str) \
+	([]() { \
+		struct Literal : FormatLiteral \
+		{ \
+			static constexpr std::string_view value() { return str; } \
+		}; \
+		return Literal(); \
+	}())
+
+
+template <typename S>
+using EnableIfFormatLiteral = std::enable_if_t<std::is_base_of<FormatLiteral, S>::value>;
+
+
+struct FormatSpec
+{
+	enum Flags
+	{
+		FLAG_LEFT  = 1,
+		FLAG_PLUS  = 2,
+		FLAG_ZERO  = 4,
+		FLAG_ALT   = 8
+	};
+
+	std::size_t literalPos = 0;
+	std::size_t literalLength = 0;
+	int         flags = 0;
+	int         width = 0;
+	int         precision = -1;
+	int         widthArg = -1;
+	int         precisionArg = -1;
+	int         arg = -1;
+	char        type = 0;
+};
+
+
+class FormatWriter
+{
+public:
+	static void appendInteger(std::string& result, const FormatSpec& spec, UInt64 magnitude, bool negative);
+
+	static void appendFloat(std::string& result, const FormatSpec& spec, double value);
+
+	static void appendString(std::string& result, const FormatSpec& spec, const char* str, std::size_t length);
+
+	template <typename T>
+	static void append(std::string& result, const FormatSpec& spec, const T& value);
+
+	template <typename T>
+	static int toInt(const T& value);
+
+	static constexpr std::size_t count(std::string_view fmt);
+
+	template <std::size_t N>
+	static constexpr std::array<FormatSpec, N> parse(std::string_view fmt);
+
+	static constexpr int maxArg(const FormatSpec* specs, std::size_t n);
+
+	template <typename T>
+	static constexpr bool accepts(char type);
+
+private:
+	template <typename T>
+	struct IsString : std::integral_constant<bool,
+		std::is_same<T, std::string>::value ||
+		std::is_same<T, std::string_view>::value ||
+		std::is_same<std::decay_t<T>, const char*>::value ||
+		std::is_same<std::decay_t<T>, char*>::value>
+	{
+	};
+
+	static constexpr bool isDigit(char c);
+	static constexpr bool isType(char c);
+	static constexpr std::size_t parseOne(std::string_view fmt, std::size_t pos, FormatSpec& spec, int& next);
+};
+
+
+template <typename S>
+struct FormatParser
+{
+	static constexpr std::string_view fmt = S::value();
+	static constexpr std::size_t count = FormatWriter::count(fmt);
+	static constexpr std::array<FormatSpec, count> specs = FormatWriter::parse<count>(fmt);
+	static constexpr int args = FormatWriter::maxArg(specs.data(), count) + 1;
+};
+
+
+template <typename S, std::size_t I, typename Tuple>
+void formatSpec(std::string& result, const Tuple& args)
+{
+	using Parser = FormatParser<S>;
+	constexpr FormatSpec spec = Parser::specs[I];
+	result.append(Parser::fmt.data() + spec.literalPos, spec.literalLength);
+	if constexpr (spec.arg < 0)
+	{
+		if (spec.type) result += spec.type;
+	}
+	else if constexpr (spec.widthArg < 0 && spec.precisionArg < 0)
+	{
+		static_assert(FormatWriter::accepts<std::decay_t<std::tuple_element_t<spec.arg, Tuple>>>(spec.type), "format argument type does not match its conversion");
+		FormatWriter::append(result, spec, std::get<spec.arg>(args));
+	}
+	else
+	{
+		static_assert(FormatWriter::accepts<std::decay_t<std::tuple_element_t<spec.arg, Tuple>>>(spec.type), "format argument type does not match its conversion");
+		FormatSpec dynamic = spec;
+		if constexpr (spec.widthArg >= 0)
+		{
+			dynamic.width = FormatWriter::toInt(std::get<spec.widthArg>(args));
+			if (dynamic.width < 0)
+			{
+				dynamic.flags |= FormatSpec::FLAG_LEFT;
+				dynamic.width = -dynamic.width;
+			}
+		}
+		if constexpr (spec.precisionArg >= 0)
+		{
+			dynamic.precision = FormatWriter::toInt(std::get<spec.precisionArg>(args));
+		}
+		FormatWriter::append(result, dynamic, std::get<spec.arg>(args));
+	}
+}
+
+
+template <typename S, typename Tuple, std::size_t... I>
+void formatSpecs(std::string& result, const Tuple& args, std::index_sequence<I...>)
+{
+	(formatSpec<S, I>(result, args), ...);
+}
+
+
+template <
+	typename S,
+	typename... Args,
+	typename = EnableIfFormatLiteral<S>>
+	void format(std::string& result, S, const Args&... args)
+{
+	using Parser = FormatParser<S>;
+	static_assert(Parser::args <= static_cast<int>(sizeof...(Args)), "format string references more arguments than were passed");
+	result.reserve(result.size() + Parser::fmt.size() + 8 * sizeof...(Args));
+	formatSpecs<S>(result, std::forward_as_tuple(args...), std::make_index_sequence<Parser::count>());
+}
+
+
+template <
+	typename S,
+	typename... Args,
+	typename = EnableIfFormatLiteral<S>>
+	std::string format(S fmt, const Args&... args)
+{
+	std::string result;
+	format(result, fmt, args...);
+	return result;
+}
+
+
+//
+// inlines
+//
+
+template <typename T>
+inline void FormatWriter::append(std::string& result, const FormatSpec& spec, const T& value)
+{
+	if constexpr (IsString<T>::value)
+	{
+		std::string_view str(value);
+		appendString(result, spec, str.data(), str.size());
+	}
+	else if constexpr (std::is_floating_point<T>::value)
+	{
+		appendFloat(result, spec, static_cast<double>(value));
+	}
+	else
+	{
+		using I = typename std::conditional<std::is_enum<T>::value, std::underlying_type<T>, std::common_type<T>>::type::type;
+		I v = static_cast<I>(value);
+		if (spec.type == 'c')
+		{
+			char c = static_cast<char>(v);
+			appendString(result, spec, &c, 1);
+		}
+		else if constexpr (std::is_signed<I>::value)
+		{
+			if (v < 0 && (spec.type == 'd' || spec.type == 'i'))
+				appendInteger(result, spec, 0 - static_cast<UInt64>(static_cast<Int64>(v)), true);
+			else
+				appendInteger(result, spec, static_cast<std::make_unsigned_t<I>>(v), false);
+		}
+		else
+		{
+			appendInteger(result, spec, static_cast<UInt64>(v), false);
+		}
+	}
+}
+
+
+template <typename T>
+inline int FormatWriter::toInt(const T& value)
+{
+	static_assert(std::is_integral<T>::value, "'*' width and precision arguments must be integers");
+	return static_cast<int>(value);
+}
+
+
+template <typename T>
+constexpr bool FormatWriter::accepts(char type)
+{
+	if constexpr (IsString<T>::value)
+		return type == 's';
+	else if constexpr (std::is_floating_point<T>::value)
+		return type == 'e' || type == 'E' || type == 'f';
+	else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value)
+		return type != 's' && type != 'e' && type != 'E' && type != 'f';
+	else
+		return false;
+}
+
+
+constexpr bool FormatWriter::isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+
+constexpr bool FormatWriter::isType(char c)
+{
+	switch (c)
+	{
+	case 'b': case 'c': case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+	case 'e': case 'E': case 'f': case 's': case 'z':
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+constexpr std::size_t FormatWriter::parseOne(std::string_view fmt, std::size_t pos, FormatSpec& spec, int& next)
+{
+	bool indexed = pos < fmt.size() && fmt[pos] == '[';
+	int arg = next;
+	if (indexed)
+	{
+		++pos;
+		arg = 0;
+		while (pos < fmt.size() && isDigit(fmt[pos])) arg = 10 * arg + (fmt[pos++] - '0');
+		if (pos < fmt.size() && fmt[pos] == ']') ++pos;
+	}
+	for (bool isFlag = true; isFlag && pos < fmt.size(); )
+	{
+		switch (fmt[pos])
+		{
+		case '-': spec.flags |= FormatSpec::FLAG_LEFT; ++pos; break;
+		case '+': spec.flags |= FormatSpec::FLAG_PLUS; ++pos; break;
+		case '0': spec.flags |= FormatSpec::FLAG_ZERO; ++pos; break;
+		case '#': spec.flags |= FormatSpec::FLAG_ALT; ++pos; break;
+		default:  isFlag = false; break;
+		}
+	}
+	if (pos < fmt.size() && fmt[pos] == '*')
+	{
+		++pos;
+		spec.widthArg = arg++;
+	}
+	else
+	{
+		while (pos < fmt.size() && isDigit(fmt[pos])) spec.width = 10 * spec.width + (fmt[pos++] - '0');
+	}
+	if (pos < fmt.size() && fmt[pos] == '.')
+	{
+		++pos;
+		spec.precision = 0;
+		if (pos < fmt.size() && fmt[pos] == '*')
+		{
+			++pos;
+			spec.precisionArg = arg++;
+		}
+		else
+		{
+			while (pos < fmt.size() && isDigit(fmt[pos])) spec.precision = 10 * spec.precision + (fmt[pos++] - '0');
+		}
+	}
+	if (pos < fmt.size() && (fmt[pos] == 'l' || fmt[pos] == 'h' || fmt[pos] == 'L' || fmt[pos] == '?')) ++pos;
+	if (pos < fmt.size())
+	{
+		spec.type = fmt[pos++];
+		if (isType(spec.type))
+		{
+			spec.arg = arg++;
+			if (!indexed) next = arg;
+		}
+	}
+	return pos;
+}
+
+
+constexpr std::size_t FormatWriter::count(std::string_view fmt)
+{
+	std::size_t n = 1;
+	int next = 0;
+	for (std::size_t pos = 0; pos < fmt.size(); )
+	{
+		if (fmt[pos++] == '%')
+		{
+			FormatSpec spec;
+			pos = parseOne(fmt, pos, spec, next);
+			++n;
+		}
+	}
+	return n;
+}
+
+
+template <std::size_t N>
+constexpr std::array<FormatSpec, N> FormatWriter::parse(std::string_view fmt)
+{
+	std::array<FormatSpec, N> specs{};
+	std::size_t n = 0;
+	std::size_t literal = 0;
+	int next = 0;
+	for (std::size_t pos = 0; pos < fmt.size(); )
+	{
+		if (fmt[pos] == '%')
+		{
+			FormatSpec& spec = specs[n++];
+			spec.literalPos = literal;
+			spec.literalLength = pos - literal;
+			pos = parseOne(fmt, pos + 1, spec, next);
+			literal = pos;
+		}
+		else ++pos;
+	}
+	specs[n].literalPos = literal;
+	specs[n].literalLength = fmt.size() - literal;
+	return specs;
+}
+
+
+constexpr int FormatWriter::maxArg(const FormatSpec* specs, std::size_t n)
+{
+	int max = -1;
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		if (specs[i].arg > max) max = specs[i].arg;
+		if (specs[i].widthArg > max) max = specs[i].widthArg;
+		if (specs[i].precisionArg > max) max = specs[i].precisionArg;
+	}
+	return max;
+}
@@ -0,0 +1,72 @@
+#include "FrameArena.h"
+#include "Bugcheck.h"
+
+
+FrameArena::FrameArena(std::size_t chunkSize):
+	_pos(nullptr),
+	_begin(nullptr),
+	_end(nullptr),
+	_pChunks(nullptr),
+	_chunkSize(chunkSize),
+	_retired(0),
+	_capacity(0)
+{
+	addChunk(_chunkSize);
+}
+
+
+FrameArena::~FrameArena()
+{
+	freeChunks();
+}
+
+
+void* FrameArena::allocateSlow(std::size_t size, std::size_t alignment)
+{
+	ASSERT(alignment && (alignment & (alignment - 1)) == 0);
+
+	_retired += _pos - _begin;
+	std::size_t needed = size + alignment;
+	addChunk(needed > _chunkSize ? needed : _chunkSize);
+	return allocate(size, alignment);
+}
+
+
+void FrameArena::reset()
+{
+	if (_pChunks && _pChunks->next)
+	{
+		std::size_t total = _capacity;
+		freeChunks();
+		addChunk(total);
+	}
+	_pos = _begin;
+	_retired = 0;
+}
+
+
+void FrameArena::addChunk(std::size_t size)
+{
+	Chunk* pChunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + size));
+	pChunk->next = _pChunks;
+	pChunk->size = size;
+	_pChunks = pChunk;
+	_capacity += size;
+
+	_begin = reinterpret_cast<char*>(pChunk + 1);
+	_pos = _begin;
+	_end = _begin + size;
+}
+
+
+void FrameArena::freeChunks()
+{
+	while (_pChunks)
+	{
+		Chunk* pNext = _pChunks->next;
+		::operator delete(_pChunks);
+		_pChunks = pNext;
+	}
+	_pos = _begin = _end = nullptr;
+	_capacity = 0;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+// Bump allocator for data that lives for one tick. Allocation moves a
+// pointer; individual frees are no-ops and reset() reclaims everything at
+// once. When a frame spills into extra chunks, reset() replaces them with a
+// single chunk large enough for the whole frame, so steady-state ticks
+// allocate from one block without touching the heap.
+//
+// Not thread safe: use one arena per thread. Destructors are never run, so
+// create() only accepts trivially destructible types; containers using an
+// ArenaAllocator must be destroyed before reset().
+class FrameArena
+{
+public:
+	explicit FrameArena(std::size_t chunkSize = 64 * 1024);
+
+	~FrameArena();
+
+	void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+	template <class T, class... Args>
+	T* create(Args&&... args);
+
+	void reset();
+
+	std::size_t used() const;
+
+	std::size_t capacity() const;
+
+private:
+	struct Chunk
+	{
+		Chunk*      next;
+		std::size_t size;
+	};
+
+	FrameArena(const FrameArena&);
+	FrameArena& operator = (const FrameArena&);
+
+	void* allocateSlow(std::size_t size, std::size_t alignment);
+	void addChunk(std::size_t size);
+	void freeChunks();
+
+	char*       _pos;
+	char*       _begin;
+	char*       _end;
+	Chunk*      _pChunks;
+	std::size_t _chunkSize;
+	std::size_t _retired;
+	std::size_t _capacity;
+};
+
+
+// Standard allocator that draws from a FrameArena.
+template <class T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	explicit ArenaAllocator(FrameArena& arena) noexcept:
+		_pArena(&arena)
+	{
+	}
+
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept:
+		_pArena(other.arena())
+	{
+	}
+
+	T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(_pArena->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, std::size_t) noexcept
+	{
+	}
+
+	FrameArena* arena() const noexcept
+	{
+		return _pArena;
+	}
+
+private:
+	FrameArena* _pArena;
+};
+
+
+template <class T, class U>
+inline bool operator == (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.arena() == b.arena();
+}
+
+
+template <class T, class U>
+inline bool operator != (const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.arena() != b.arena();
+}
+
+
+//
+// inlines
+//
+inline void* FrameArena::allocate(std::size_t size, std::size_t alignment)
+{
+	std::uintptr_t pos = (reinterpret_cast<std::uintptr_t>(_pos) + alignment - 1) & ~(alignment - 1);
+	if (pos + size <= reinterpret_cast<std::uintptr_t>(_end))
+	{
+		_pos = reinterpret_cast<char*>(pos + size);
+		return reinterpret_cast<void*>(pos);
+	}
+	return allocateSlow(size, alignment);
+}
+
+
+template <class T, class... Args>
+inline T* FrameArena::create(Args&&... args)
+{
+	static_assert(std::is_trivially_destructible<T>::value, "FrameArena does not run destructors");
+	return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+}
+
+
+inline std::size_t FrameArena::used() const
+{
+	return _retired + (_pos - _begin);
+}
+
+
+inline std::size_t FrameArena::capacity() const
+{
+	return _capacity;
+}
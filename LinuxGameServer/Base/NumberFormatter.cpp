@@ -11,10 +11,12 @@
 
 #include "NumberFormatter.h"
 #include "Bugcheck.h"
+#include "double-conversion.h"
 #include <locale>
 #include <iomanip>
 #include <cstdio>
 #include <cinttypes>
+#include <cstring>
 
 
 #if defined(_MSC_VER)
@@ -26,6 +28,213 @@
 #endif
 
 
+namespace
+{
+	const char DIGIT_PAIRS[] =
+		"00010203040506070809"
+		"10111213141516171819"
+		"20212223242526272829"
+		"30313233343536373839"
+		"40414243444546474849"
+		"50515253545556575859"
+		"60616263646566676869"
+		"70717273747576777879"
+		"80818283848586878889"
+		"90919293949596979899";
+
+	const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+
+	inline std::size_t countDigits(UInt64 value)
+	{
+		std::size_t n = 1;
+		for (;;)
+		{
+			if (value < 10) return n;
+			if (value < 100) return n + 1;
+			if (value < 1000) return n + 2;
+			if (value < 10000) return n + 3;
+			value /= 10000;
+			n += 4;
+		}
+	}
+
+
+	inline void writeDecimal(char* end, UInt64 value)
+	{
+		while (value >= 100)
+		{
+			std::size_t i = static_cast<std::size_t>(value % 100) * 2;
+			value /= 100;
+			end -= 2;
+			std::memcpy(end, DIGIT_PAIRS + i, 2);
+		}
+		if (value >= 10)
+			std::memcpy(end - 2, DIGIT_PAIRS + value * 2, 2);
+		else
+			*--end = static_cast<char>('0' + value);
+	}
+
+
+	std::size_t copyPadded(char* buffer, std::size_t capacity, const char* str, std::size_t length, int width)
+	{
+		std::size_t padding = width > 0 && static_cast<std::size_t>(width) > length ? static_cast<std::size_t>(width) - length : 0;
+		if (length + padding > capacity) return 0;
+		std::memset(buffer, ' ', padding);
+		std::memcpy(buffer + padding, str, length);
+		return length + padding;
+	}
+
+
+	int converterFlags()
+	{
+		return double_conversion::DoubleToStringConverter::UNIQUE_ZERO |
+			double_conversion::DoubleToStringConverter::EMIT_POSITIVE_EXPONENT_SIGN;
+	}
+}
+
+
+std::size_t NumberFormatter::formatDecimal(char* buffer, std::size_t capacity, UInt64 magnitude, bool negative, int width, char fill)
+{
+	std::size_t digits = countDigits(magnitude);
+	std::size_t length = digits + (negative ? 1 : 0);
+	std::size_t size = width > 0 && static_cast<std::size_t>(width) > length ? static_cast<std::size_t>(width) : length;
+	if (size > capacity) return 0;
+
+	char* p = buffer;
+	if (fill == '0')
+	{
+		if (negative) *p++ = '-';
+		std::memset(p, '0', size - length);
+		p += size - length;
+	}
+	else
+	{
+		std::memset(p, fill, size - length);
+		p += size - length;
+		if (negative) *p++ = '-';
+	}
+	writeDecimal(p + digits, magnitude);
+	return size;
+}
+
+
+std::size_t NumberFormatter::formatHexadecimal(char* buffer, std::size_t capacity, UInt64 value, int width, bool prefix)
+{
+	std::size_t digits = value ? (67 - __builtin_clzll(value)) / 4 : 1;
+	std::size_t length = digits + (prefix ? 2 : 0);
+	std::size_t size = width > 0 && static_cast<std::size_t>(width) > length ? static_cast<std::size_t>(width) : length;
+	if (size > capacity) return 0;
+
+	char* p = buffer;
+	if (prefix)
+	{
+		*p++ = '0';
+		*p++ = 'x';
+	}
+	std::memset(p, '0', size - length);
+	p += size - length + digits;
+	do
+	{
+		*--p = HEX_DIGITS[value & 0xF];
+		value >>= 4;
+	}
+	while (value);
+	return size;
+}
+
+
+std::size_t NumberFormatter::formatFixed(char* buffer, std::size_t capacity, double value, int width, int precision)
+{
+	char result[NF_MAX_FLT_STRING_LEN];
+	std::size_t length = formatTo(result, sizeof(result), value, precision);
+	return copyPadded(buffer, capacity, result, length, width);
+}
+
+
+std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, float value)
+{
+	using namespace double_conversion;
+
+	char result[NF_MAX_FLT_STRING_LEN];
+	StringBuilder builder(result, sizeof(result));
+	DoubleToStringConverter dc(converterFlags(), FLT_INF, FLT_NAN, FLT_EXP, -std::numeric_limits<float>::digits10, std::numeric_limits<float>::digits10, 0, 0);
+	dc.ToShortestSingle(value, &builder);
+	int length = builder.position();
+	if (length < 0) return 0;
+	return copyPadded(buffer, capacity, result, static_cast<std::size_t>(length), 0);
+}
+
+
+std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, float value, int precision)
+{
+	using namespace double_conversion;
+
+	char result[NF_MAX_FLT_STRING_LEN];
+	StringBuilder builder(result, sizeof(result));
+	DoubleToStringConverter dc(converterFlags(), FLT_INF, FLT_NAN, FLT_EXP, -std::numeric_limits<float>::digits10, std::numeric_limits<float>::digits10, 0, 0);
+	dc.ToFixed(value, precision, &builder);
+	int length = builder.position();
+	if (length < 0) return 0;
+	return copyPadded(buffer, capacity, result, static_cast<std::size_t>(length), 0);
+}
+
+
+std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, double value)
+{
+	using namespace double_conversion;
+
+	char result[NF_MAX_FLT_STRING_LEN];
+	StringBuilder builder(result, sizeof(result));
+	DoubleToStringConverter dc(converterFlags(), FLT_INF, FLT_NAN, FLT_EXP, -std::numeric_limits<double>::digits10, std::numeric_limits<double>::digits10, 0, 0);
+	dc.ToShortest(value, &builder);
+	int length = builder.position();
+	if (length < 0) return 0;
+	return copyPadded(buffer, capacity, result, static_cast<std::size_t>(length), 0);
+}
+
+
+std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, double value, int precision)
+{
+	using namespace double_conversion;
+
+	char result[NF_MAX_FLT_STRING_LEN];
+	StringBuilder builder(result, sizeof(result));
+	DoubleToStringConverter dc(converterFlags(), FLT_INF, FLT_NAN, FLT_EXP, -std::numeric_limits<double>::digits10, std::numeric_limits<double>::digits10, 0, 0);
+	dc.ToFixed(value, precision, &builder);
+	int length = builder.position();
+	if (length < 0) return 0;
+	return copyPadded(buffer, capacity, result, static_cast<std::size_t>(length), 0);
+}
+
+
+std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, const void* ptr)
+{
+	return formatHexadecimal(buffer, capacity, reinterpret_cast<UIntPtr>(ptr), 8, false);
+}
+
+
+std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, bool value, BoolFormat format)
+{
+	const char* str;
+	switch (format)
+	{
+	case FMT_YES_NO:
+		str = value ? "yes" : "no";
+		break;
+
+	case FMT_ON_OFF:
+		str = value ? "on" : "off";
+		break;
+
+	default: // including FMT_TRUE_FALSE:
+		str = value ? "true" : "false";
+		break;
+	}
+	return copyPadded(buffer, capacity, str, std::strlen(str), 0);
+}
+
+
 std::string NumberFormatter::format(bool value, BoolFormat format)
 {
 	switch (format)
@@ -41,234 +250,205 @@ std::string NumberFormatter::format(bool value, BoolFormat format)
 	}
 }
 
+
 void NumberFormatter::append(std::string& str, Int32 value)
 {
 	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	intToStr(value, 10, result, sz);
-	str.append(result, sz);
+	str.append(result, formatTo(result, sizeof(result), value));
 }
 
 
 void NumberFormatter::append(std::string& str, Int32 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	intToStr(value, 10, result, sz, false, width);
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + formatTo(&str[pos], str.size() - pos, value, width));
 }
 
 
 void NumberFormatter::append0(std::string& str, Int32 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	intToStr(value, 10, result, sz, false, width, '0');
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + format0To(&str[pos], str.size() - pos, value, width));
 }
 
 
 void NumberFormatter::appendHex(std::string& str, Int32 value)
 {
 	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(static_cast<unsigned int>(value), 0x10, result, sz);
-	str.append(result, sz);
+	str.append(result, formatHexTo(result, sizeof(result), value));
 }
 
 
 void NumberFormatter::appendHex(std::string& str, Int32 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(static_cast<unsigned int>(value), 0x10, result, sz, false, width, '0');
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + formatHexTo(&str[pos], str.size() - pos, value, width));
 }
 
 
 void NumberFormatter::append(std::string& str, UInt32 value)
 {
 	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(value, 10, result, sz);
-	str.append(result, sz);
+	str.append(result, formatTo(result, sizeof(result), value));
 }
 
 
 void NumberFormatter::append(std::string& str, UInt32 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(value, 10, result, sz, false, width);
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + formatTo(&str[pos], str.size() - pos, value, width));
 }
 
 
 void NumberFormatter::append0(std::string& str, UInt32 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(value, 10, result, sz, false, width, '0');
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + format0To(&str[pos], str.size() - pos, value, width));
 }
 
 
 void NumberFormatter::appendHex(std::string& str, UInt32 value)
 {
 	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(value, 0x10, result, sz);
-	str.append(result, sz);
+	str.append(result, formatHexTo(result, sizeof(result), value));
 }
 
 
 void NumberFormatter::appendHex(std::string& str, UInt32 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(value, 0x10, result, sz, false, width, '0');
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + formatHexTo(&str[pos], str.size() - pos, value, width));
 }
 
 
 void NumberFormatter::append(std::string& str, Int64 value)
 {
 	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	intToStr(value, 10, result, sz);
-	str.append(result, sz);
+	str.append(result, formatTo(result, sizeof(result), value));
 }
 
 
 void NumberFormatter::append(std::string& str, Int64 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	intToStr(value, 10, result, sz, false, width, '0');
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + formatTo(&str[pos], str.size() - pos, value, width));
 }
 
 
 void NumberFormatter::append0(std::string& str, Int64 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	intToStr(value, 10, result, sz, false, width, '0');
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + format0To(&str[pos], str.size() - pos, value, width));
 }
 
 
 void NumberFormatter::appendHex(std::string& str, Int64 value)
 {
 	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(static_cast<UInt64>(value), 0x10, result, sz);
-	str.append(result, sz);
+	str.append(result, formatHexTo(result, sizeof(result), value));
 }
 
 
 void NumberFormatter::appendHex(std::string& str, Int64 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(static_cast<UInt64>(value), 0x10, result, sz, false, width, '0');
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + formatHexTo(&str[pos], str.size() - pos, value, width));
 }
 
 
 void NumberFormatter::append(std::string& str, UInt64 value)
 {
 	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(value, 10, result, sz);
-	str.append(result, sz);
+	str.append(result, formatTo(result, sizeof(result), value));
 }
 
 
 void NumberFormatter::append(std::string& str, UInt64 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(value, 10, result, sz, false, width, '0');
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + formatTo(&str[pos], str.size() - pos, value, width));
 }
 
 
 void NumberFormatter::append0(std::string& str, UInt64 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(value, 10, result, sz, false, width, '0');
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + format0To(&str[pos], str.size() - pos, value, width));
 }
 
 
 void NumberFormatter::appendHex(std::string& str, UInt64 value)
 {
 	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(value, 0x10, result, sz);
-	str.append(result, sz);
+	str.append(result, formatHexTo(result, sizeof(result), value));
 }
 
 
 void NumberFormatter::appendHex(std::string& str, UInt64 value, int width)
 {
-	char result[NF_MAX_INT_STRING_LEN];
-	std::size_t sz = NF_MAX_INT_STRING_LEN;
-	uIntToStr(value, 0x10, result, sz, false, width, '0');
-	str.append(result, sz);
+	std::size_t pos = str.size();
+	str.resize(pos + capacityFor(width));
+	str.resize(pos + formatHexTo(&str[pos], str.size() - pos, value, width));
 }
 
+
 void NumberFormatter::append(std::string& str, float value)
 {
 	char buffer[NF_MAX_FLT_STRING_LEN];
-	floatToStr(buffer, NF_MAX_FLT_STRING_LEN, value);
-	str.append(buffer);
+	str.append(buffer, formatTo(buffer, sizeof(buffer), value));
 }
 
 
 void NumberFormatter::append(std::string& str, float value, int precision)
 {
 	char buffer[NF_MAX_FLT_STRING_LEN];
-	floatToFixedStr(buffer, NF_MAX_FLT_STRING_LEN, value, precision);
-	str.append(buffer);
+	str.append(buffer, formatTo(buffer, sizeof(buffer), value, precision));
 }
 
 
 void NumberFormatter::append(std::string& str, float value, int width, int precision)
 {
-	std::string result;
-	str.append(floatToFixedStr(result, value, precision, width));
+	std::size_t pos = str.size();
+	str.resize(pos + NF_MAX_FLT_STRING_LEN + (width > 0 ? width : 0));
+	str.resize(pos + formatTo(&str[pos], str.size() - pos, value, width, precision));
 }
 
 
 void NumberFormatter::append(std::string& str, double value)
 {
 	char buffer[NF_MAX_FLT_STRING_LEN];
-	doubleToStr(buffer, NF_MAX_FLT_STRING_LEN, value);
-	str.append(buffer);
+	str.append(buffer, formatTo(buffer, sizeof(buffer), value));
 }
 
 
 void NumberFormatter::append(std::string& str, double value, int precision)
 {
 	char buffer[NF_MAX_FLT_STRING_LEN];
-	doubleToFixedStr(buffer, NF_MAX_FLT_STRING_LEN, value, precision);
-	str.append(buffer);
+	str.append(buffer, formatTo(buffer, sizeof(buffer), value, precision));
 }
 
 
 void NumberFormatter::append(std::string& str, double value, int width, int precision)
 {
-	std::string result;
-	str.append(doubleToFixedStr(result, value, precision, width));
+	std::size_t pos = str.size();
+	str.resize(pos + NF_MAX_FLT_STRING_LEN + (width > 0 ? width : 0));
+	str.resize(pos + formatTo(&str[pos], str.size() - pos, value, width, precision));
 }
 
 
 void NumberFormatter::append(std::string& str, const void* ptr)
 {
 	char buffer[24];
-	std::sprintf(buffer, "%08" PRIXPTR, (UIntPtr)ptr);
-	str.append(buffer);
+	str.append(buffer, formatTo(buffer, sizeof(buffer), ptr));
 }
@@ -156,6 +156,74 @@ public:
 
 	static void append(std::string& str, const void* ptr);
 
+public:
+	/// Writes the value into buffer without a terminating zero and returns the
+	/// number of characters written, or 0 (writing nothing) if it does not fit.
+	static std::size_t formatTo(char* buffer, std::size_t capacity, Int32 value);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, Int32 value, int width);
+
+	static std::size_t format0To(char* buffer, std::size_t capacity, Int32 value, int width);
+
+	static std::size_t formatHexTo(char* buffer, std::size_t capacity, Int32 value, bool prefix = false);
+
+	static std::size_t formatHexTo(char* buffer, std::size_t capacity, Int32 value, int width, bool prefix = false);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, UInt32 value);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, UInt32 value, int width);
+
+	static std::size_t format0To(char* buffer, std::size_t capacity, UInt32 value, int width);
+
+	static std::size_t formatHexTo(char* buffer, std::size_t capacity, UInt32 value, bool prefix = false);
+
+	static std::size_t formatHexTo(char* buffer, std::size_t capacity, UInt32 value, int width, bool prefix = false);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, Int64 value);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, Int64 value, int width);
+
+	static std::size_t format0To(char* buffer, std::size_t capacity, Int64 value, int width);
+
+	static std::size_t formatHexTo(char* buffer, std::size_t capacity, Int64 value, bool prefix = false);
+
+	static std::size_t formatHexTo(char* buffer, std::size_t capacity, Int64 value, int width, bool prefix = false);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, UInt64 value);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, UInt64 value, int width);
+
+	static std::size_t format0To(char* buffer, std::size_t capacity, UInt64 value, int width);
+
+	static std::size_t formatHexTo(char* buffer, std::size_t capacity, UInt64 value, bool prefix = false);
+
+	static std::size_t formatHexTo(char* buffer, std::size_t capacity, UInt64 value, int width, bool prefix = false);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, float value);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, float value, int precision);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, float value, int width, int precision);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, double value);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, double value, int precision);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, double value, int width, int precision);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, const void* ptr);
+
+	static std::size_t formatTo(char* buffer, std::size_t capacity, bool value, BoolFormat format = FMT_TRUE_FALSE);
+
+private:
+	static std::size_t formatDecimal(char* buffer, std::size_t capacity, UInt64 magnitude, bool negative, int width, char fill);
+
+	static std::size_t formatHexadecimal(char* buffer, std::size_t capacity, UInt64 value, int width, bool prefix);
+
+	static std::size_t formatFixed(char* buffer, std::size_t capacity, double value, int width, int precision);
+
+	static std::size_t capacityFor(int width);
+
 public:
 	/// ֵתΪַ,ַвλ
 	template <class T>
@@ -215,16 +283,15 @@ std::string NumberFormatter::format_separator(const T& nValue, int nSplitNum)
 
 inline std::string NumberFormatter::format(Int32 value)
 {
-	std::string result;
-	intToStr(value, 10, result);
-	return result;
+	char buffer[NF_MAX_INT_STRING_LEN];
+	return std::string(buffer, formatTo(buffer, sizeof(buffer), value));
 }
 
 
 inline std::string NumberFormatter::format(Int32 value, int width)
 {
 	std::string result;
-	intToStr(value, 10, result, false, width, ' ');
+	append(result, value, width);
 	return result;
 }
 
@@ -232,39 +299,37 @@ inline std::string NumberFormatter::format(Int32 value, int width)
 inline std::string NumberFormatter::format0(Int32 value, int width)
 {
 	std::string result;
-	intToStr(value, 10, result, false, width, '0');
+	append0(result, value, width);
 	return result;
 }
 
 
 inline std::string NumberFormatter::formatHex(Int32 value, bool prefix)
 {
-	std::string result;
-	uIntToStr(static_cast<unsigned int>(value), 0x10, result, prefix);
-	return result;
+	char buffer[NF_MAX_INT_STRING_LEN];
+	return std::string(buffer, formatHexTo(buffer, sizeof(buffer), value, prefix));
 }
 
 
 inline std::string NumberFormatter::formatHex(Int32 value, int width, bool prefix)
 {
-	std::string result;
-	uIntToStr(static_cast<unsigned int>(value), 0x10, result, prefix, width, '0');
+	std::string result(capacityFor(width), '\0');
+	result.resize(formatHexTo(&result[0], result.size(), value, width, prefix));
 	return result;
 }
 
 
 inline std::string NumberFormatter::format(UInt32 value)
 {
-	std::string result;
-	uIntToStr(value, 10, result);
-	return result;
+	char buffer[NF_MAX_INT_STRING_LEN];
+	return std::string(buffer, formatTo(buffer, sizeof(buffer), value));
 }
 
 
 inline std::string NumberFormatter::format(UInt32 value, int width)
 {
 	std::string result;
-	uIntToStr(value, 10, result, false, width, ' ');
+	append(result, value, width);
 	return result;
 }
 
@@ -272,39 +337,37 @@ inline std::string NumberFormatter::format(UInt32 value, int width)
 inline std::string NumberFormatter::format0(UInt32 value, int width)
 {
 	std::string result;
-	uIntToStr(value, 10, result, false, width, '0');
+	append0(result, value, width);
 	return result;
 }
 
 
 inline std::string NumberFormatter::formatHex(UInt32 value, bool prefix)
 {
-	std::string result;
-	uIntToStr(value, 0x10, result, prefix);
-	return result;
+	char buffer[NF_MAX_INT_STRING_LEN];
+	return std::string(buffer, formatHexTo(buffer, sizeof(buffer), value, prefix));
 }
 
 
 inline std::string NumberFormatter::formatHex(UInt32 value, int width, bool prefix)
 {
-	std::string result;
-	uIntToStr(value, 0x10, result, prefix, width, '0');
+	std::string result(capacityFor(width), '\0');
+	result.resize(formatHexTo(&result[0], result.size(), value, width, prefix));
 	return result;
 }
 
 
 inline std::string NumberFormatter::format(Int64 value)
 {
-	std::string result;
-	intToStr(value, 10, result);
-	return result;
+	char buffer[NF_MAX_INT_STRING_LEN];
+	return std::string(buffer, formatTo(buffer, sizeof(buffer), value));
 }
 
 
 inline std::string NumberFormatter::format(Int64 value, int width)
 {
 	std::string result;
-	intToStr(value, 10, result, false, width, ' ');
+	append(result, value, width);
 	return result;
 }
 
@@ -312,39 +375,37 @@ inline std::string NumberFormatter::format(Int64 value, int width)
 inline std::string NumberFormatter::format0(Int64 value, int width)
 {
 	std::string result;
-	intToStr(value, 10, result, false, width, '0');
+	append0(result, value, width);
 	return result;
 }
 
 
 inline std::string NumberFormatter::formatHex(Int64 value, bool prefix)
 {
-	std::string result;
-	uIntToStr(static_cast<UInt64>(value), 0x10, result, prefix);
-	return result;
+	char buffer[NF_MAX_INT_STRING_LEN];
+	return std::string(buffer, formatHexTo(buffer, sizeof(buffer), value, prefix));
 }
 
 
 inline std::string NumberFormatter::formatHex(Int64 value, int width, bool prefix)
 {
-	std::string result;
-	uIntToStr(static_cast<UInt64>(value), 0x10, result, prefix, width, '0');
+	std::string result(capacityFor(width), '\0');
+	result.resize(formatHexTo(&result[0], result.size(), value, width, prefix));
 	return result;
 }
 
 
 inline std::string NumberFormatter::format(UInt64 value)
 {
-	std::string result;
-	uIntToStr(value, 10, result);
-	return result;
+	char buffer[NF_MAX_INT_STRING_LEN];
+	return std::string(buffer, formatTo(buffer, sizeof(buffer), value));
 }
 
 
 inline std::string NumberFormatter::format(UInt64 value, int width)
 {
 	std::string result;
-	uIntToStr(value, 10, result, false, width, ' ');
+	append(result, value, width);
 	return result;
 }
 
@@ -352,70 +413,65 @@ inline std::string NumberFormatter::format(UInt64 value, int width)
 inline std::string NumberFormatter::format0(UInt64 value, int width)
 {
 	std::string result;
-	uIntToStr(value, 10, result, false, width, '0');
+	append0(result, value, width);
 	return result;
 }
 
 
 inline std::string NumberFormatter::formatHex(UInt64 value, bool prefix)
 {
-	std::string result;
-	uIntToStr(value, 0x10, result, prefix);
-	return result;
+	char buffer[NF_MAX_INT_STRING_LEN];
+	return std::string(buffer, formatHexTo(buffer, sizeof(buffer), value, prefix));
 }
 
 
 inline std::string NumberFormatter::formatHex(UInt64 value, int width, bool prefix)
 {
-	std::string result;
-	uIntToStr(value, 0x10, result, prefix, width, '0');
+	std::string result(capacityFor(width), '\0');
+	result.resize(formatHexTo(&result[0], result.size(), value, width, prefix));
 	return result;
 }
 
 inline std::string NumberFormatter::format(float value)
 {
-	char buffer[MAX_FLT_STRING_LEN];
-	floatToStr(buffer, MAX_FLT_STRING_LEN, value);
-	return std::string(buffer);
+	char buffer[NF_MAX_FLT_STRING_LEN];
+	return std::string(buffer, formatTo(buffer, sizeof(buffer), value));
 }
 
 
 inline std::string NumberFormatter::format(float value, int precision)
 {
-	char buffer[MAX_FLT_STRING_LEN];
-	floatToFixedStr(buffer, MAX_FLT_STRING_LEN, value, precision);
-	return std::string(buffer);
+	char buffer[NF_MAX_FLT_STRING_LEN];
+	return std::string(buffer, formatTo(buffer, sizeof(buffer), value, precision));
 }
 
 
 inline std::string NumberFormatter::format(float value, int width, int precision)
 {
 	std::string result;
-	floatToFixedStr(result, value, precision, width);
+	append(result, value, width, precision);
 	return result;
 }
 
 
 inline std::string NumberFormatter::format(double value)
 {
-	char buffer[MAX_FLT_STRING_LEN];
-	doubleToStr(buffer, MAX_FLT_STRING_LEN, value);
-	return std::string(buffer);
+	char buffer[NF_MAX_FLT_STRING_LEN];
+	return std::string(buffer, formatTo(buffer, sizeof(buffer), value));
 }
 
 
 inline std::string NumberFormatter::format(double value, int precision)
 {
-	char buffer[MAX_FLT_STRING_LEN];
-	doubleToFixedStr(buffer, MAX_FLT_STRING_LEN, value, precision);
-	return std::string(buffer);
+	char buffer[NF_MAX_FLT_STRING_LEN];
+	return std::string(buffer, formatTo(buffer, sizeof(buffer), value, precision));
 }
 
 
 inline std::string NumberFormatter::format(double value, int width, int precision)
 {
 	std::string result;
-	doubleToFixedStr(result, value, precision, width);
+	append(result, value, width, precision);
 	return result;
 }
 
@@ -426,3 +482,141 @@ inline std::string NumberFormatter::format(const void* ptr)
 	append(result, ptr);
 	return result;
 }
+
+
+inline std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, Int32 value)
+{
+	return formatDecimal(buffer, capacity, value < 0 ? 0 - static_cast<UInt64>(value) : static_cast<UInt64>(value), value < 0, -1, ' ');
+}
+
+
+inline std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, Int32 value, int width)
+{
+	return formatDecimal(buffer, capacity, value < 0 ? 0 - static_cast<UInt64>(value) : static_cast<UInt64>(value), value < 0, width, ' ');
+}
+
+
+inline std::size_t NumberFormatter::format0To(char* buffer, std::size_t capacity, Int32 value, int width)
+{
+	return formatDecimal(buffer, capacity, value < 0 ? 0 - static_cast<UInt64>(value) : static_cast<UInt64>(value), value < 0, width, '0');
+}
+
+
+inline std::size_t NumberFormatter::formatHexTo(char* buffer, std::size_t capacity, Int32 value, bool prefix)
+{
+	return formatHexadecimal(buffer, capacity, static_cast<UInt32>(value), -1, prefix);
+}
+
+
+inline std::size_t NumberFormatter::formatHexTo(char* buffer, std::size_t capacity, Int32 value, int width, bool prefix)
+{
+	return formatHexadecimal(buffer, capacity, static_cast<UInt32>(value), width, prefix);
+}
+
+
+inline std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, UInt32 value)
+{
+	return formatDecimal(buffer, capacity, value, false, -1, ' ');
+}
+
+
+inline std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, UInt32 value, int width)
+{
+	return formatDecimal(buffer, capacity, value, false, width, ' ');
+}
+
+
+inline std::size_t NumberFormatter::format0To(char* buffer, std::size_t capacity, UInt32 value, int width)
+{
+	return formatDecimal(buffer, capacity, value, false, width, '0');
+}
+
+
+inline std::size_t NumberFormatter::formatHexTo(char* buffer, std::size_t capacity, UInt32 value, bool prefix)
+{
+	return formatHexadecimal(buffer, capacity, value, -1, prefix);
+}
+
+
+inline std::size_t NumberFormatter::formatHexTo(char* buffer, std::size_t capacity, UInt32 value, int width, bool prefix)
+{
+	return formatHexadecimal(buffer, capacity, value, width, prefix);
+}
+
+
+inline std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, Int64 value)
+{
+	return formatDecimal(buffer, capacity, value < 0 ? 0 - static_cast<UInt64>(value) : static_cast<UInt64>(value), value < 0, -1, ' ');
+}
+
+
+inline std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, Int64 value, int width)
+{
+	return formatDecimal(buffer, capacity, value < 0 ? 0 - static_cast<UInt64>(value) : static_cast<UInt64>(value), value < 0, width, ' ');
+}
+
+
+inline std::size_t NumberFormatter::format0To(char* buffer, std::size_t capacity, Int64 value, int width)
+{
+	return formatDecimal(buffer, capacity, value < 0 ? 0 - static_cast<UInt64>(value) : static_cast<UInt64>(value), value < 0, width, '0');
+}
+
+
+inline std::size_t NumberFormatter::formatHexTo(char* buffer, std::size_t capacity, Int64 value, bool prefix)
+{
+	return formatHexadecimal(buffer, capacity, static_cast<UInt64>(value), -1, prefix);
+}
+
+
+inline std::size_t NumberFormatter::formatHexTo(char* buffer, std::size_t capacity, Int64 value, int width, bool prefix)
+{
+	return formatHexadecimal(buffer, capacity, static_cast<UInt64>(value), width, prefix);
+}
+
+
+inline std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, UInt64 value)
+{
+	return formatDecimal(buffer, capacity, value, false, -1, ' ');
+}
+
+
+inline std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, UInt64 value, int width)
+{
+	return formatDecimal(buffer, capacity, value, false, width, ' ');
+}
+
+
+inline std::size_t NumberFormatter::format0To(char* buffer, std::size_t capacity, UInt64 value, int width)
+{
+	return formatDecimal(buffer, capacity, value, false, width, '0');
+}
+
+
+inline std::size_t NumberFormatter::formatHexTo(char* buffer, std::size_t capacity, UInt64 value, bool prefix)
+{
+	return formatHexadecimal(buffer, capacity, value, -1, prefix);
+}
+
+
+inline std::size_t NumberFormatter::formatHexTo(char* buffer, std::size_t capacity, UInt64 value, int width, bool prefix)
+{
+	return formatHexadecimal(buffer, capacity, value, width, prefix);
+}
+
+
+inline std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, float value, int width, int precision)
+{
+	return formatFixed(buffer, capacity, value, width, precision);
+}
+
+
+inline std::size_t NumberFormatter::formatTo(char* buffer, std::size_t capacity, double value, int width, int precision)
+{
+	return formatFixed(buffer, capacity, value, width, precision);
+}
+
+
+inline std::size_t NumberFormatter::capacityFor(int width)
+{
+	return width > static_cast<int>(NF_MAX_INT_STRING_LEN) ? static_cast<std::size_t>(width) : NF_MAX_INT_STRING_LEN;
+}
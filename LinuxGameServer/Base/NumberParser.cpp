@@ -10,21 +10,40 @@
 ***********************************************************************/
 
 #include "NumberParser.h"
+#include "NumericString.h"
 #include "BaseException.h"
-#include <cstdio>
 #include <cctype>
 
 
-#if defined(_MSC_VER)
-#	define I64_FMT "I64"
-#elif defined(__APPLE__) 
-#	define I64_FMT "q"
-#else
-#	define I64_FMT "ll"
-#endif
+namespace
+{
+	std::string_view trimmed(std::string_view s)
+	{
+		while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+		while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+		return s;
+	}
+
+
+	template <typename I>
+	bool parseDecimal(std::string_view s, I& value)
+	{
+		s = trimmed(s);
+		return !s.empty() && strToInt(s, value, 10, 0);
+	}
+
+
+	template <typename I>
+	bool parseHexadecimal(std::string_view s, I& value)
+	{
+		s = trimmed(s);
+		if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) s.remove_prefix(2);
+		return !s.empty() && strToInt(s, value, 0x10, 0);
+	}
+}
 
 
-int NumberParser::parse(const std::string& s)
+int NumberParser::parse(std::string_view s)
 {
 	int result = 0;
 	if (tryParse(s, result))
@@ -33,17 +52,16 @@ int NumberParser::parse(const std::string& s)
 	}
 	else
 	{
-		throw SyntaxException("Not a valid integer", s);
+		throw SyntaxException("Not a valid integer", std::string(s));
 	}
 }
 
-bool NumberParser::tryParse(const std::string& s, int& value)
+bool NumberParser::tryParse(std::string_view s, int& value)
 {
-	//char temp = 0;
-	return std::sscanf(s.c_str(), "%d", &value) == 1;
+	return parseDecimal(s, value);
 }
 
-unsigned NumberParser::parseUnsigned(const std::string& s)
+unsigned NumberParser::parseUnsigned(std::string_view s)
 {
 	unsigned result = 0;
 	if (tryParseUnsigned(s, result))
@@ -52,17 +70,16 @@ unsigned NumberParser::parseUnsigned(const std::string& s)
 	}
 	else
 	{
-		throw SyntaxException("Not a valid unsigned integer", s);
+		throw SyntaxException("Not a valid unsigned integer", std::string(s));
 	}
 }
 
-bool NumberParser::tryParseUnsigned(const std::string& s, unsigned& value)
+bool NumberParser::tryParseUnsigned(std::string_view s, unsigned& value)
 {
-	//char temp = 0;
-	return std::sscanf(s.c_str(), "%u", &value) == 1;
+	return parseDecimal(s, value);
 }
 
-unsigned NumberParser::parseHex(const std::string& s)
+unsigned NumberParser::parseHex(std::string_view s)
 {
 	unsigned result = 0;
 	if (tryParseHex(s, result))
@@ -71,17 +88,16 @@ unsigned NumberParser::parseHex(const std::string& s)
 	}
 	else
 	{
-		throw SyntaxException("Not a valid hexadecimal integer", s);
+		throw SyntaxException("Not a valid hexadecimal integer", std::string(s));
 	}
 }
 
-bool NumberParser::tryParseHex(const std::string& s, unsigned& value)
+bool NumberParser::tryParseHex(std::string_view s, unsigned& value)
 {
-	//char temp = 0;
-	return std::sscanf(s.c_str(), "%x", &value) == 1;
+	return parseHexadecimal(s, value);
 }
 
-long NumberParser::parseLong(const std::string& s)
+long NumberParser::parseLong(std::string_view s)
 {
 	long result = 0;
 	if (tryParseLong(s, result))
@@ -90,17 +106,16 @@ long NumberParser::parseLong(const std::string& s)
 	}
 	else
 	{
-		throw SyntaxException("Not a valid long integer", s);
+		throw SyntaxException("Not a valid long integer", std::string(s));
 	}
 }
 
-bool NumberParser::tryParseLong(const std::string& s, long& value)
+bool NumberParser::tryParseLong(std::string_view s, long& value)
 {
-	//char temp = 0;
-	return std::sscanf(s.c_str(), "%ld", &value) == 1;
+	return parseDecimal(s, value);
 }
 
-unsigned long NumberParser::parseUlong(const std::string& s)
+unsigned long NumberParser::parseUlong(std::string_view s)
 {
 	unsigned long result = 0;
 	if (tryParseUlong(s, result))
@@ -109,17 +124,16 @@ unsigned long NumberParser::parseUlong(const std::string& s)
 	}
 	else
 	{
-		throw SyntaxException("Not a valid unsigned long integer", s);
+		throw SyntaxException("Not a valid unsigned long integer", std::string(s));
 	}
 }
 
-bool NumberParser::tryParseUlong(const std::string& s, unsigned long& value)
+bool NumberParser::tryParseUlong(std::string_view s, unsigned long& value)
 {
-	//char temp = 0;
-	return std::sscanf(s.c_str(), "%uld", &value) == 1;
+	return parseDecimal(s, value);
 }
 
-long long NumberParser::parseLongLong(const std::string& s)
+long long NumberParser::parseLongLong(std::string_view s)
 {
 	long long result = 0;
 	if (tryParseLongLong(s, result))
@@ -128,17 +142,16 @@ long long NumberParser::parseLongLong(const std::string& s)
 	}
 	else
 	{
-		throw SyntaxException("Not a valid long long integer", s);
+		throw SyntaxException("Not a valid long long integer", std::string(s));
 	}
 }
 
-bool NumberParser::tryParseLongLong(const std::string& s, long long& value)
+bool NumberParser::tryParseLongLong(std::string_view s, long long& value)
 {
-	//char temp = 0;
-	return std::sscanf(s.c_str(), "%I64d", &value) == 1;
+	return parseDecimal(s, value);
 }
 
-Int64 NumberParser::parse64(const std::string& s)
+Int64 NumberParser::parse64(std::string_view s)
 {
 	Int64 result = 0;
 	if (tryParse64(s, result))
@@ -147,17 +160,16 @@ Int64 NumberParser::parse64(const std::string& s)
 	}
 	else
 	{
-		throw SyntaxException("Not a valid integer", s);
+		throw SyntaxException("Not a valid integer", std::string(s));
 	}
 }
 
-bool NumberParser::tryParse64(const std::string& s, Int64& value)
+bool NumberParser::tryParse64(std::string_view s, Int64& value)
 {
-	//char temp = 0;
-	return std::sscanf(s.c_str(), "%I64d", &value) == 1;
+	return parseDecimal(s, value);
 }
 
-UInt64 NumberParser::parseUnsigned64(const std::string& s)
+UInt64 NumberParser::parseUnsigned64(std::string_view s)
 {
 	UInt64 result = 0;
 	if (tryParseUnsigned64(s, result))
@@ -166,17 +178,16 @@ UInt64 NumberParser::parseUnsigned64(const std::string& s)
 	}
 	else
 	{
-		throw SyntaxException("Not a valid unsigned integer", s);
+		throw SyntaxException("Not a valid unsigned integer", std::string(s));
 	}
 }
 
-bool NumberParser::tryParseUnsigned64(const std::string& s, UInt64& value)
+bool NumberParser::tryParseUnsigned64(std::string_view s, UInt64& value)
 {
-	//char temp = 0;
-	return std::sscanf(s.c_str(), "%I64u", &value) == 1;
+	return parseDecimal(s, value);
 }
 
-UInt64 NumberParser::parseHex64(const std::string& s)
+UInt64 NumberParser::parseHex64(std::string_view s)
 {
 	UInt64 result = 0;
 	if (tryParseHex64(s, result))
@@ -185,17 +196,16 @@ UInt64 NumberParser::parseHex64(const std::string& s)
 	}
 	else
 	{
-		throw SyntaxException("Not a valid hexadecimal integer", s);
+		throw SyntaxException("Not a valid hexadecimal integer", std::string(s));
 	}
 }
 
-bool NumberParser::tryParseHex64(const std::string& s, UInt64& value)
+bool NumberParser::tryParseHex64(std::string_view s, UInt64& value)
 {
-	//char temp = 0;
-	return std::sscanf(s.c_str(), "%I64x", &value) == 1;
+	return parseHexadecimal(s, value);
 }
 
-float NumberParser::parseFloat(const std::string& s)
+float NumberParser::parseFloat(std::string_view s)
 {
 	float result = 0;
 	if (tryParseFloat(s, result))
@@ -204,29 +214,30 @@ float NumberParser::parseFloat(const std::string& s)
 	}
 	else
 	{
-		throw SyntaxException("Not a valid floating-point number", s);
+		throw SyntaxException("Not a valid floating-point number", std::string(s));
 	}
 }
 
-bool NumberParser::tryParseFloat(const std::string& s, float& value)
+bool NumberParser::tryParseFloat(std::string_view s, float& value)
 {
-	return std::sscanf(s.c_str(), "%f", &value) == 1;
+	s = trimmed(s);
+	return !s.empty() && strToFloat(s, value);
 }
 
-double NumberParser::parseDouble(const std::string& s)
+double NumberParser::parseDouble(std::string_view s)
 {
-	double result = 0.0f;
+	double result = 0.0;
 	if (tryParseDouble(s, result))
 	{
 		return result;
 	}
 	else
 	{
-		throw SyntaxException("Not a valid floating-point number", s);
+		throw SyntaxException("Not a valid floating-point number", std::string(s));
 	}
 }
 
-bool NumberParser::tryParseDouble(const std::string& s, double& value)
+bool NumberParser::tryParseDouble(std::string_view s, double& value)
 {
-	return std::sscanf(s.c_str(), "%lf", &value) == 1;
+	return strToDouble(s, value);
 }
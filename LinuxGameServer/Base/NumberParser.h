@@ -13,6 +13,7 @@
 
 #include "Types.h"
 #include <string>
+#include <string_view>
 
 class NumberParser
 {
@@ -20,61 +21,61 @@ public:
 	/// ַΪ
 	/// @param[in] s Ҫַ
 	/// @return 
-	static int parse(const std::string& s);
+	static int parse(std::string_view s);
 
 	/// ַΪ
 	/// @param[in] s Ҫַ
 	/// @param[out] value 
 	/// @return ɹ
-	static bool tryParse(const std::string& s, int& value);
+	static bool tryParse(std::string_view s, int& value);
 
 public:
-	static unsigned parseUnsigned(const std::string& s);
+	static unsigned parseUnsigned(std::string_view s);
 
-	static bool tryParseUnsigned(const std::string& s, unsigned& value);
+	static bool tryParseUnsigned(std::string_view s, unsigned& value);
 
-	static unsigned parseHex(const std::string& s);
+	static unsigned parseHex(std::string_view s);
 
-	static bool tryParseHex(const std::string& s, unsigned& value);
+	static bool tryParseHex(std::string_view s, unsigned& value);
 
 public:
-	static long parseLong(const std::string& s);
+	static long parseLong(std::string_view s);
 
-	static bool tryParseLong(const std::string& s, long& value);
+	static bool tryParseLong(std::string_view s, long& value);
 
 public:
-	static unsigned long parseUlong(const std::string& s);
+	static unsigned long parseUlong(std::string_view s);
 
-	static bool tryParseUlong(const std::string& s, unsigned long& value);
+	static bool tryParseUlong(std::string_view s, unsigned long& value);
 
 public:
-	static	long long parseLongLong(const std::string& str);
+	static	long long parseLongLong(std::string_view str);
 
-	static bool tryParseLongLong(const std::string& str, long long& value);
+	static bool tryParseLongLong(std::string_view str, long long& value);
 
 public:
 
 public:
-	static Int64 parse64(const std::string& s);
+	static Int64 parse64(std::string_view s);
 
-	static bool tryParse64(const std::string& s, Int64& value);
+	static bool tryParse64(std::string_view s, Int64& value);
 
 public:
-	static UInt64 parseUnsigned64(const std::string& s);
+	static UInt64 parseUnsigned64(std::string_view s);
 
-	static bool tryParseUnsigned64(const std::string& s, UInt64& value);
+	static bool tryParseUnsigned64(std::string_view s, UInt64& value);
 
-	static UInt64 parseHex64(const std::string& s);
+	static UInt64 parseHex64(std::string_view s);
 
-	static bool tryParseHex64(const std::string& s, UInt64& value);
+	static bool tryParseHex64(std::string_view s, UInt64& value);
 
 public:
-	static float parseFloat(const std::string& s);
+	static float parseFloat(std::string_view s);
 
-	static bool tryParseFloat(const std::string& s, float& value);
+	static bool tryParseFloat(std::string_view s, float& value);
 
 public:
-	static	double parseDouble(const std::string& s);
+	static	double parseDouble(std::string_view s);
 
-	static bool tryParseDouble(const std::string& s, double& value);
+	static bool tryParseDouble(std::string_view s, double& value);
 };
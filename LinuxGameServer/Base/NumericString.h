@@ -4,6 +4,7 @@
 #include "BaseException.h"
 #include "Bugcheck.h"
 #include "FPEnvironment.h"
+#include "Types.h"
 
 #ifdef min
 #undef min
@@ -16,6 +17,9 @@
 #include <cmath>
 #include <cctype>
 #include <locale>
+#include <cstring>
+#include <string>
+#include <string_view>
 
 
 //#define INTMAX_MAX std::numeric_limits<intmax_t>::max()
@@ -48,6 +52,37 @@ namespace Impl
 		bool operator()(T) { return false; }
 	};
 
+
+	// Eight ASCII characters packed little-endian, so the first character is
+	// in the lowest byte and the digit arithmetic below can run on all lanes.
+	inline UInt64 loadEight(const char* p)
+	{
+		UInt64 v;
+		std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		v = __builtin_bswap64(v);
+#endif
+		return v;
+	}
+
+
+	inline bool isEightDigits(UInt64 v)
+	{
+		return ((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+	}
+
+
+	inline UInt32 parseEightDigits(UInt64 v)
+	{
+		const UInt64 mask = 0x000000FF000000FFULL;
+		const UInt64 mul1 = 100 + (1000000ULL << 32);
+		const UInt64 mul2 = 1 + (10000ULL << 32);
+		v -= 0x3030303030303030ULL;
+		v = (v * 10) + (v >> 8);
+		v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+		return static_cast<UInt32>(v);
+	}
+
 }
 
 
@@ -113,13 +148,14 @@ inline char thousandSeparator()
 
 
 template <typename I>
-bool strToInt(const char* pStr, I& outResult, short base, char thSep = ',')
+bool strToInt(std::string_view str, I& outResult, short base, char thSep = ',')
 {
 	ASSERT_DBG(base == 2 || base == 8 || base == 10 || base == 16);
 
-	if (!pStr) return false;
-	while (std::isspace(*pStr)) ++pStr;
-	if (*pStr == '\0') return false;
+	const char* pStr = str.data();
+	const char* pEnd = pStr + str.size();
+	while (pStr != pEnd && std::isspace(*pStr)) ++pStr;
+	if (pStr == pEnd) return false;
 	bool negative = false;
 	if ((base == 10) && (*pStr == '-'))
 	{
@@ -128,13 +164,14 @@ bool strToInt(const char* pStr, I& outResult, short base, char thSep = ',')
 		++pStr;
 	}
 	else if (*pStr == '+') ++pStr;
+	if (pStr == pEnd) return false;
 
 	uintmax_t limitCheck = std::numeric_limits<I>::max();
 	if (negative)
 	{
 		ASSERT_DBG(std::numeric_limits<I>::is_signed);
 		if (sizeof(I) == sizeof(intmax_t))
-			limitCheck = static_cast<uintmax_t>(FPEnvironment::copySign(static_cast<double>(std::numeric_limits<I>::min()), 1));
+			limitCheck = static_cast<uintmax_t>(INTMAX_MAX) + 1;
 		else
 		{
 			intmax_t i = std::numeric_limits<I>::min();
@@ -143,71 +180,73 @@ bool strToInt(const char* pStr, I& outResult, short base, char thSep = ',')
 	}
 
 	uintmax_t result = 0;
-	for (; *pStr != '\0'; ++pStr)
+	if (base == 10)
+	{
+		while (pEnd - pStr >= 8)
+		{
+			UInt64 chunk = Impl::loadEight(pStr);
+			if (!Impl::isEightDigits(chunk)) break;
+			uintmax_t add = Impl::parseEightDigits(chunk);
+			if (add > limitCheck || result > (limitCheck - add) / 100000000) return false;
+			result = result * 100000000 + add;
+			pStr += 8;
+		}
+	}
+	for (; pStr != pEnd; ++pStr)
 	{
-		if (result > (limitCheck / base)) return false;
+		uintmax_t add;
 		switch (*pStr)
 		{
 		case '0': case '1': case '2': case '3':
 		case '4': case '5': case '6': case '7':
-		{
-			char add = (*pStr - '0');
-			if ((limitCheck - result) < add) return false;
-			result = result * base + add;
-		}
-		break;
+			add = static_cast<uintmax_t>(*pStr - '0');
+			break;
 
 		case '8': case '9':
 			if ((base == 10) || (base == 0x10))
-			{
-				char  add = (*pStr - '0');
-				if ((limitCheck - result) < add) return false;
-				result = result * base + add;
-			}
+				add = static_cast<uintmax_t>(*pStr - '0');
 			else return false;
-
 			break;
 
 		case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
-		{
 			if (base != 0x10) return false;
-			char  add = (*pStr - 'a');
-			if ((limitCheck - result) < add) return false;
-			result = result * base + (10 + add);
-		}
-		break;
+			add = static_cast<uintmax_t>(10 + (*pStr - 'a'));
+			break;
 
 		case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
-		{
 			if (base != 0x10) return false;
-			char add = (*pStr - 'A');
-			if ((limitCheck - result) < add) return false;
-			result = result * base + (10 + add);
-		}
-		break;
+			add = static_cast<uintmax_t>(10 + (*pStr - 'A'));
+			break;
 
 		case '.':
-			if ((base == 10) && (thSep == '.')) break;
+			if ((base == 10) && (thSep == '.')) continue;
 			else return false;
 
 		case ',':
-			if ((base == 10) && (thSep == ',')) break;
+			if ((base == 10) && (thSep == ',')) continue;
 			else return false;
 
 		case ' ':
-			if ((base == 10) && (thSep == ' ')) break;
+			if ((base == 10) && (thSep == ' ')) continue;
+			else return false;
 
 		default:
 			return false;
 		}
+
+		// result * base + add must not exceed limitCheck, which for 64-bit
+		// types is the full uintmax_t range, so test before multiplying.
+		if (add > limitCheck || result > (limitCheck - add) / static_cast<uintmax_t>(base)) return false;
+		result = result * static_cast<uintmax_t>(base) + add;
 	}
 
 	if (negative && (base == 10))
 	{
 		ASSERT_DBG(std::numeric_limits<I>::is_signed);
+		if (result > limitCheck) return false;
 		intmax_t i;
 		if (sizeof(I) == sizeof(intmax_t))
-			i = static_cast<intmax_t>(FPEnvironment::copySign(static_cast<double>(result), -1));
+			i = result ? -static_cast<intmax_t>(result - 1) - 1 : 0;
 		else
 			i = static_cast<intmax_t>(-result);
 		if (isIntOverflow<I>(i)) return false;
@@ -223,10 +262,18 @@ bool strToInt(const char* pStr, I& outResult, short base, char thSep = ',')
 }
 
 
+template <typename I>
+bool strToInt(const char* pStr, I& outResult, short base, char thSep = ',')
+{
+	if (!pStr) return false;
+	return strToInt(std::string_view(pStr), outResult, base, thSep);
+}
+
+
 template <typename I>
 bool strToInt(const std::string& str, I& result, short base, char thSep = ',')
 {
-	return strToInt(str.c_str(), result, base, thSep);
+	return strToInt(std::string_view(str), result, base, thSep);
 }
 
 
@@ -523,7 +570,7 @@ float strToFloat(const char* str,
 	const char* inf = FLT_INF, const char* nan = FLT_NAN);
 
 
-bool strToFloat(const std::string&, float& result,
+bool strToFloat(std::string_view str, float& result,
 	char decSep = '.', char thSep = ',',
 	const char* inf = FLT_INF, const char* nan = FLT_NAN);
 
@@ -532,6 +579,6 @@ double strToDouble(const char* str,
 	const char* inf = FLT_INF, const char* nan = FLT_NAN);
 
 
-bool strToDouble(const std::string& str, double& result,
+bool strToDouble(std::string_view str, double& result,
 	char decSep = '.', char thSep = ',',
 	const char* inf = FLT_INF, const char* nan = FLT_NAN);
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+// Fixed-size object pool with a per-thread cache in front of a global depot.
+//
+// Each thread keeps a free list of up to 2 * BatchSize nodes. Allocation and
+// deallocation touch only that list; whole batches move between the thread
+// and the depot under a mutex when the list runs dry or overflows. Nodes can
+// be freed on any thread. Memory is carved from chunks of BatchSize nodes
+// and is retained for the lifetime of the process.
+template <class T, std::size_t BatchSize = 64>
+class ObjectPool
+{
+public:
+	static void* allocate();
+
+	static void deallocate(void* p) noexcept;
+
+	template <class... Args>
+	static T* create(Args&&... args);
+
+	static void destroy(T* p) noexcept;
+
+	// Returns the calling thread's cached nodes to the depot.
+	static void flush() noexcept;
+
+private:
+	union Node
+	{
+		Node* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	struct List
+	{
+		Node*       head;
+		std::size_t count;
+	};
+
+	class Depot
+	{
+	public:
+		List pop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (!_lists.empty())
+				{
+					List list = _lists.back();
+					_lists.pop_back();
+					return list;
+				}
+			}
+			return carve();
+		}
+
+		void push(const List& list)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_lists.push_back(list);
+		}
+
+	private:
+		static List carve()
+		{
+			Node* pChunk = static_cast<Node*>(alignof(Node) > __STDCPP_DEFAULT_NEW_ALIGNMENT__
+				? ::operator new(BatchSize * sizeof(Node), std::align_val_t(alignof(Node)))
+				: ::operator new(BatchSize * sizeof(Node)));
+			for (std::size_t i = 0; i + 1 < BatchSize; ++i)
+				pChunk[i].next = &pChunk[i + 1];
+			pChunk[BatchSize - 1].next = nullptr;
+			return List{pChunk, BatchSize};
+		}
+
+		std::mutex        _mutex;
+		std::vector<List> _lists;
+	};
+
+	struct Cache: List
+	{
+		Cache(): List{nullptr, 0}
+		{
+		}
+
+		~Cache()
+		{
+			release(*this);
+		}
+	};
+
+	static Depot& depot();
+	static Cache& cache();
+	static void release(List& list) noexcept;
+};
+
+
+// Standard allocator backed by ObjectPool. Single-object allocations, which
+// is what node based containers (list, map, unordered_map) make, come from
+// the pool; arrays fall back to std::allocator.
+template <class T>
+class PoolAllocator
+{
+public:
+	typedef T value_type;
+
+	PoolAllocator() noexcept
+	{
+	}
+
+	template <class U>
+	PoolAllocator(const PoolAllocator<U>&) noexcept
+	{
+	}
+
+	T* allocate(std::size_t n)
+	{
+		if (n == 1)
+			return static_cast<T*>(ObjectPool<T>::allocate());
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T* p, std::size_t n) noexcept
+	{
+		if (n == 1)
+			ObjectPool<T>::deallocate(p);
+		else
+			std::allocator<T>().deallocate(p, n);
+	}
+};
+
+
+template <class T, class U>
+inline bool operator == (const PoolAllocator<T>&, const PoolAllocator<U>&)
+{
+	return true;
+}
+
+
+template <class T, class U>
+inline bool operator != (const PoolAllocator<T>&, const PoolAllocator<U>&)
+{
+	return false;
+}
+
+
+// Base class that routes new/delete of T through ObjectPool<T>. Derived
+// classes of a different size fall back to the global heap, so the
+// destructor must be virtual if T is deleted through a base pointer.
+template <class T>
+class PooledObject
+{
+public:
+	static void* operator new(std::size_t size)
+	{
+		return size == sizeof(T) ? ObjectPool<T>::allocate() : ::operator new(size);
+	}
+
+	static void operator delete(void* p, std::size_t size) noexcept
+	{
+		if (size == sizeof(T))
+			ObjectPool<T>::deallocate(p);
+		else
+			::operator delete(p);
+	}
+};
+
+
+//
+// inlines
+//
+template <class T, std::size_t BatchSize>
+typename ObjectPool<T, BatchSize>::Depot& ObjectPool<T, BatchSize>::depot()
+{
+	// Never destroyed: thread caches may flush into it during exit.
+	static Depot* pDepot = new Depot;
+	return *pDepot;
+}
+
+
+template <class T, std::size_t BatchSize>
+typename ObjectPool<T, BatchSize>::Cache& ObjectPool<T, BatchSize>::cache()
+{
+	static thread_local Cache cache;
+	return cache;
+}
+
+
+template <class T, std::size_t BatchSize>
+inline void* ObjectPool<T, BatchSize>::allocate()
+{
+	Cache& c = cache();
+	if (!c.head)
+		static_cast<List&>(c) = depot().pop();
+	Node* pNode = c.head;
+	c.head = pNode->next;
+	--c.count;
+	return pNode;
+}
+
+
+template <class T, std::size_t BatchSize>
+inline void ObjectPool<T, BatchSize>::deallocate(void* p) noexcept
+{
+	if (!p) return;
+
+	Cache& c = cache();
+	Node* pNode = static_cast<Node*>(p);
+	pNode->next = c.head;
+	c.head = pNode;
+	if (++c.count >= 2 * BatchSize)
+	{
+		Node* pLast = c.head;
+		for (std::size_t i = 1; i < BatchSize; ++i)
+			pLast = pLast->next;
+		List spill{c.head, BatchSize};
+		c.head = pLast->next;
+		c.count -= BatchSize;
+		pLast->next = nullptr;
+		depot().push(spill);
+	}
+}
+
+
+template <class T, std::size_t BatchSize>
+template <class... Args>
+inline T* ObjectPool<T, BatchSize>::create(Args&&... args)
+{
+	void* p = allocate();
+	try
+	{
+		return new (p) T(std::forward<Args>(args)...);
+	}
+	catch (...)
+	{
+		deallocate(p);
+		throw;
+	}
+}
+
+
+template <class T, std::size_t BatchSize>
+inline void ObjectPool<T, BatchSize>::destroy(T* p) noexcept
+{
+	if (!p) return;
+	p->~T();
+	deallocate(p);
+}
+
+
+template <class T, std::size_t BatchSize>
+void ObjectPool<T, BatchSize>::release(List& list) noexcept
+{
+	if (list.head)
+	{
+		try
+		{
+			depot().push(list);
+		}
+		catch (...)
+		{
+			return;
+		}
+		list.head = nullptr;
+		list.count = 0;
+	}
+}
+
+
+template <class T, std::size_t BatchSize>
+inline void ObjectPool<T, BatchSize>::flush() noexcept
+{
+	release(cache());
+}
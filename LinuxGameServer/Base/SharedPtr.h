@@ -34,6 +34,35 @@ private:
 };
 
 
+// Non-atomic counter for SharedPtrs that never leave the thread that
+// created them.
+class UnsafeReferenceCounter
+{
+public:
+	UnsafeReferenceCounter() : _cnt(1)
+	{
+	}
+
+	void duplicate()
+	{
+		++_cnt;
+	}
+
+	int release()
+	{
+		return --_cnt;
+	}
+
+	int referenceCount() const
+	{
+		return _cnt;
+	}
+
+private:
+	int _cnt;
+};
+
+
 template <class C>
 class ReleasePolicy
 {
@@ -416,3 +445,7 @@ SharedPtr<T, ReferenceCounter, ReleaseArrayPolicy<T>> makeSharedArray(std::size_
 {
 	return SharedPtr<T, ReferenceCounter, ReleaseArrayPolicy<T>>(new T[size]);
 }
+
+
+template <class C, class RP = ReleasePolicy<C>>
+using UnsafeSharedPtr = SharedPtr<C, UnsafeReferenceCounter, RP>;
@@ -0,0 +1,68 @@
+#include "StringViewTokenizer.h"
+
+
+StringViewTokenizer::StringViewTokenizer(std::string_view str, std::string_view separators, int options) :
+	_str(str),
+	_separatorCount(0),
+	_separator(0),
+	_trim((options & TOK_TRIM) != 0),
+	_ignoreEmpty((options & TOK_IGNORE_EMPTY) != 0)
+{
+	std::memset(_separators, 0, sizeof(_separators));
+	for (char ch : separators)
+	{
+		unsigned char c = static_cast<unsigned char>(ch);
+		if (!isSeparator(c))
+		{
+			_separators[c >> 6] |= UInt64(1) << (c & 63);
+			_separator = ch;
+			++_separatorCount;
+		}
+	}
+}
+
+
+StringViewTokenizer::~StringViewTokenizer()
+{
+}
+
+
+void StringViewTokenizer::tokens(std::vector<std::string_view>& range) const
+{
+	for (Iterator it = begin(); it != end(); ++it)
+	{
+		range.push_back(*it);
+	}
+}
+
+
+bool StringViewTokenizer::has(std::string_view token) const
+{
+	for (Iterator it = begin(); it != end(); ++it)
+	{
+		if (*it == token) return true;
+	}
+	return false;
+}
+
+
+std::size_t StringViewTokenizer::count() const
+{
+	std::size_t result = 0;
+	for (Iterator it = begin(); it != end(); ++it)
+	{
+		++result;
+	}
+	return result;
+}
+
+
+std::size_t StringViewTokenizer::count(std::string_view token) const
+{
+	std::size_t result = 0;
+	for (Iterator it = begin(); it != end(); ++it)
+	{
+		if (*it == token) ++result;
+	}
+	return result;
+}
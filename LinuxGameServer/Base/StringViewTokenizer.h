@@ -0,0 +1,208 @@
+#pragma once
+
+#include "Types.h"
+#include "Ascii.h"
+
+#include <string_view>
+#include <vector>
+#include <iterator>
+#include <cstring>
+#include <cstddef>
+
+
+// Splits a string_view lazily into views on the original string, with the
+// same token rules as StringTokenizer. Nothing is copied or allocated; the
+// tokenized string must outlive the tokenizer and its iterators.
+class StringViewTokenizer
+{
+public:
+	enum Options
+	{
+		TOK_IGNORE_EMPTY = 1,
+		TOK_TRIM = 2
+	};
+
+	class Iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const std::string_view*;
+		using reference = const std::string_view&;
+
+		Iterator();
+
+		reference operator * () const;
+		pointer operator -> () const;
+
+		Iterator& operator ++ ();
+		Iterator operator ++ (int);
+
+		bool operator == (const Iterator& other) const;
+		bool operator != (const Iterator& other) const;
+
+	private:
+		Iterator(const StringViewTokenizer* pTokenizer, std::size_t pos);
+
+		void advance();
+
+		const StringViewTokenizer* _pTokenizer;
+		std::size_t                _pos;
+		std::size_t                _next;
+		std::string_view           _token;
+
+		friend class StringViewTokenizer;
+	};
+
+	StringViewTokenizer(std::string_view str, std::string_view separators, int options = 0);
+
+	~StringViewTokenizer();
+
+	Iterator begin() const;
+	Iterator end() const;
+
+	void tokens(std::vector<std::string_view>& range) const;
+
+	bool has(std::string_view token) const;
+
+	std::size_t count() const;
+
+	std::size_t count(std::string_view token) const;
+
+private:
+	std::size_t findSeparator(std::size_t pos) const;
+	bool isSeparator(unsigned char c) const;
+
+	std::string_view _str;
+	UInt64           _separators[4];
+	int              _separatorCount;
+	char             _separator;
+	bool             _trim;
+	bool             _ignoreEmpty;
+};
+
+
+//
+// inlines
+//
+
+
+inline bool StringViewTokenizer::isSeparator(unsigned char c) const
+{
+	return (_separators[c >> 6] >> (c & 63)) & 1;
+}
+
+
+inline std::size_t StringViewTokenizer::findSeparator(std::size_t pos) const
+{
+	if (_separatorCount == 1)
+	{
+		const void* p = std::memchr(_str.data() + pos, _separator, _str.size() - pos);
+		return p ? static_cast<const char*>(p) - _str.data() : std::string_view::npos;
+	}
+	const unsigned char* it = reinterpret_cast<const unsigned char*>(_str.data()) + pos;
+	const unsigned char* end = reinterpret_cast<const unsigned char*>(_str.data()) + _str.size();
+	for (; it != end; ++it)
+	{
+		if (isSeparator(*it)) return it - reinterpret_cast<const unsigned char*>(_str.data());
+	}
+	return std::string_view::npos;
+}
+
+
+inline StringViewTokenizer::Iterator StringViewTokenizer::begin() const
+{
+	return Iterator(this, _str.empty() ? std::string_view::npos : 0);
+}
+
+
+inline StringViewTokenizer::Iterator StringViewTokenizer::end() const
+{
+	return Iterator(this, std::string_view::npos);
+}
+
+
+inline StringViewTokenizer::Iterator::Iterator() :
+	_pTokenizer(nullptr),
+	_pos(std::string_view::npos),
+	_next(std::string_view::npos)
+{
+}
+
+
+inline StringViewTokenizer::Iterator::Iterator(const StringViewTokenizer* pTokenizer, std::size_t pos) :
+	_pTokenizer(pTokenizer),
+	_pos(pos),
+	_next(pos)
+{
+	advance();
+}
+
+
+inline void StringViewTokenizer::Iterator::advance()
+{
+	const StringViewTokenizer& tok = *_pTokenizer;
+	while (_next != std::string_view::npos)
+	{
+		_pos = _next;
+		std::size_t sep = tok.findSeparator(_pos);
+		if (sep == std::string_view::npos)
+		{
+			_token = tok._str.substr(_pos);
+			_next = std::string_view::npos;
+		}
+		else
+		{
+			_token = tok._str.substr(_pos, sep - _pos);
+			_next = sep + 1;
+		}
+		if (tok._trim)
+		{
+			while (!_token.empty() && Ascii::isSpace(static_cast<unsigned char>(_token.front()))) _token.remove_prefix(1);
+			while (!_token.empty() && Ascii::isSpace(static_cast<unsigned char>(_token.back()))) _token.remove_suffix(1);
+		}
+		if (!_token.empty() || !tok._ignoreEmpty) return;
+	}
+	_pos = std::string_view::npos;
+	_token = std::string_view();
+}
+
+
+inline StringViewTokenizer::Iterator::reference StringViewTokenizer::Iterator::operator * () const
+{
+	return _token;
+}
+
+
+inline StringViewTokenizer::Iterator::pointer StringViewTokenizer::Iterator::operator -> () const
+{
+	return &_token;
+}
+
+
+inline StringViewTokenizer::Iterator& StringViewTokenizer::Iterator::operator ++ ()
+{
+	advance();
+	return *this;
+}
+
+
+inline StringViewTokenizer::Iterator StringViewTokenizer::Iterator::operator ++ (int)
+{
+	Iterator tmp(*this);
+	advance();
+	return tmp;
+}
+
+
+inline bool StringViewTokenizer::Iterator::operator == (const Iterator& other) const
+{
+	return _pos == other._pos;
+}
+
+
+inline bool StringViewTokenizer::Iterator::operator != (const Iterator& other) const
+{
+	return _pos != other._pos;
+}
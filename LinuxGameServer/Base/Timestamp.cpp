@@ -82,8 +82,8 @@ Timestamp Timestamp::fromUtcTime(UtcTimeVal val)
 
 void Timestamp::update()
 {
-	struct timeval tv;
-	if (gettimeofday(&tv, NULL))
+	struct timespec ts;
+	if (clock_gettime(CLOCK_REALTIME, &ts))
 		throw SystemException("cannot get time of day");
-	m_ts = TimeVal(tv.tv_sec) * resolution() + tv.tv_usec;
+	m_ts = TimeVal(ts.tv_sec) * resolution() + ts.tv_nsec / 1000;
 }
@@ -0,0 +1,10 @@
+#include "UnsafeRefCountedObject.h"
+
+UnsafeRefCountedObject::UnsafeRefCountedObject() : _counter(1)
+{
+}
+
+
+UnsafeRefCountedObject::~UnsafeRefCountedObject()
+{
+}
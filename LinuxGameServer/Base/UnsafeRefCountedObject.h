@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Bugcheck.h"
+
+
+// RefCountedObject with a plain int counter, for objects that are only
+// referenced from a single thread (zone logic, entities). Use with AutoPtr
+// exactly like RefCountedObject.
+class UnsafeRefCountedObject
+{
+public:
+	UnsafeRefCountedObject();
+
+	void duplicate() const;
+
+	void release() const noexcept;
+
+	int referenceCount() const;
+
+protected:
+	virtual ~UnsafeRefCountedObject();
+
+private:
+	UnsafeRefCountedObject(const UnsafeRefCountedObject&);
+	UnsafeRefCountedObject& operator = (const UnsafeRefCountedObject&);
+
+	mutable int _counter;
+};
+
+
+inline int UnsafeRefCountedObject::referenceCount() const
+{
+	return _counter;
+}
+
+
+inline void UnsafeRefCountedObject::duplicate() const
+{
+	++_counter;
+}
+
+
+inline void UnsafeRefCountedObject::release() const noexcept
+{
+	try
+	{
+		if (--_counter == 0) delete this;
+	}
+	catch (...)
+	{
+		UNEXPECTED();
+	}
+}
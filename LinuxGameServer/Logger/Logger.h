@@ -42,6 +42,12 @@ public:
 		log(format(fmt, arg1, std::forward<Args>(args)...), LogPrio_Fatal);
 	}
 
+	template <typename S, typename... Args, typename = EnableIfFormatLiteral<S>>
+	void fatal(S fmt, const Args&... args)
+	{
+		if (fatal()) log(::format(fmt, args...), LogPrio_Fatal);
+	}
+
 	void critical(const std::string& msg);
 	void critical(const std::string& msg, const char* file, int line);
 
@@ -51,6 +57,12 @@ public:
 		log(format(fmt, arg1, std::forward<Args>(args)...), LogPrio_Critical);
 	}
 
+	template <typename S, typename... Args, typename = EnableIfFormatLiteral<S>>
+	void critical(S fmt, const Args&... args)
+	{
+		if (critical()) log(::format(fmt, args...), LogPrio_Critical);
+	}
+
 	void error(const std::string& msg);
 	void error(const std::string& msg, const char* file, int line);
 
@@ -60,6 +72,12 @@ public:
 		log(format(fmt, arg1, std::forward<Args>(args)...), LogPrio_Error);
 	}
 
+	template <typename S, typename... Args, typename = EnableIfFormatLiteral<S>>
+	void error(S fmt, const Args&... args)
+	{
+		if (error()) log(::format(fmt, args...), LogPrio_Error);
+	}
+
 	void warning(const std::string& msg);
 	void warning(const std::string& msg, const char* file, int line);
 
@@ -69,6 +87,12 @@ public:
 		log(format(fmt, arg1, std::forward<Args>(args)...), LogPrio_Warning);
 	}
 
+	template <typename S, typename... Args, typename = EnableIfFormatLiteral<S>>
+	void warning(S fmt, const Args&... args)
+	{
+		if (warning()) log(::format(fmt, args...), LogPrio_Warning);
+	}
+
 	void notice(const std::string& msg);
 	void notice(const std::string& msg, const char* file, int line);
 
@@ -78,6 +102,12 @@ public:
 		log(format(fmt, arg1, std::forward<Args>(args)...), LogPrio_Notice);
 	}
 
+	template <typename S, typename... Args, typename = EnableIfFormatLiteral<S>>
+	void notice(S fmt, const Args&... args)
+	{
+		if (notice()) log(::format(fmt, args...), LogPrio_Notice);
+	}
+
 	void information(const std::string& msg);
 	void information(const std::string& msg, const char* file, int line);
 
@@ -87,6 +117,12 @@ public:
 		log(format(fmt, arg1, std::forward<Args>(args)...), LogPrio_Information);
 	}
 
+	template <typename S, typename... Args, typename = EnableIfFormatLiteral<S>>
+	void information(S fmt, const Args&... args)
+	{
+		if (information()) log(::format(fmt, args...), LogPrio_Information);
+	}
+
 	void debug(const std::string& msg);
 	void debug(const std::string& msg, const char* file, int line);
 
@@ -96,6 +132,12 @@ public:
 		log(format(fmt, arg1, std::forward<Args>(args)...), LogPrio_Debug);
 	}
 
+	template <typename S, typename... Args, typename = EnableIfFormatLiteral<S>>
+	void debug(S fmt, const Args&... args)
+	{
+		if (debug()) log(::format(fmt, args...), LogPrio_Debug);
+	}
+
 	void trace(const std::string& msg);
 	void trace(const std::string& msg, const char* file, int line);
 
@@ -105,6 +147,12 @@ public:
 		log(format(fmt, arg1, std::forward<Args>(args)...), LogPrio_Trace);
 	}
 
+	template <typename S, typename... Args, typename = EnableIfFormatLiteral<S>>
+	void trace(S fmt, const Args&... args)
+	{
+		if (trace()) log(::format(fmt, args...), LogPrio_Trace);
+	}
+
 	void dump(const std::string& msg, const void* buffer, std::size_t length, LogPriority prio = LogPrio_Debug);
 
 public:
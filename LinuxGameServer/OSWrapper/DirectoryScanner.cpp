@@ -0,0 +1,234 @@
+#include "DirectoryScanner.h"
+#include "ThreadPool.h"
+#include "Event.h"
+#include "File.h"
+#include "BaseException.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+
+namespace
+{
+	struct LinuxDirent64
+	{
+		UInt64         d_ino;
+		Int64          d_off;
+		unsigned short d_reclen;
+		unsigned char  d_type;
+		char           d_name[1];
+	};
+
+
+	DirectoryScanner::EntryType typeFromMode(mode_t mode)
+	{
+		if (S_ISREG(mode)) return DirectoryScanner::TYPE_FILE;
+		if (S_ISDIR(mode)) return DirectoryScanner::TYPE_DIRECTORY;
+		if (S_ISLNK(mode)) return DirectoryScanner::TYPE_LINK;
+		return DirectoryScanner::TYPE_OTHER;
+	}
+
+
+	DirectoryScanner::EntryType typeFromDirent(unsigned char type)
+	{
+		switch (type)
+		{
+		case DT_REG: return DirectoryScanner::TYPE_FILE;
+		case DT_DIR: return DirectoryScanner::TYPE_DIRECTORY;
+		case DT_LNK: return DirectoryScanner::TYPE_LINK;
+		case DT_UNKNOWN: return DirectoryScanner::TYPE_UNKNOWN;
+		default: return DirectoryScanner::TYPE_OTHER;
+		}
+	}
+
+
+	// Shared with every task so the last one may still be inside
+	// _done.set() when walk() returns.
+	class TreeWalk: public std::enable_shared_from_this<TreeWalk>
+	{
+	public:
+		TreeWalk(const DirectoryScanner::Visitor& visitor, ThreadPool& pool):
+			_visitor(visitor),
+			_pool(pool),
+			_pending(1),
+			_failed(false),
+			_done(Event::EVENT_MANUALRESET)
+		{
+		}
+
+		void run(const std::string& root)
+		{
+			// Open the root here so a bad root throws before any task runs.
+			std::unique_ptr<DirectoryScanner> pRoot(new DirectoryScanner(root));
+			std::shared_ptr<TreeWalk> pSelf = shared_from_this();
+			DirectoryScanner* pScanner = pRoot.get();
+			_pool.startFunc([pSelf, pScanner] { pSelf->scan(pScanner); });
+			pRoot.release();
+			_done.wait();
+			if (_pError) std::rethrow_exception(_pError);
+		}
+
+	private:
+		void schedule(const std::string& path)
+		{
+			_pending.fetch_add(1, std::memory_order_relaxed);
+			try
+			{
+				std::shared_ptr<TreeWalk> pSelf = shared_from_this();
+				_pool.startFunc([pSelf, path] { pSelf->open(path); });
+			}
+			catch (...)
+			{
+				_pending.fetch_sub(1, std::memory_order_relaxed);
+				throw;
+			}
+		}
+
+		void open(const std::string& path)
+		{
+			DirectoryScanner* pScanner = nullptr;
+			try
+			{
+				if (!_failed.load(std::memory_order_relaxed))
+					pScanner = new DirectoryScanner(path);
+			}
+			catch (FileNotFoundException&)
+			{
+			}
+			catch (...)
+			{
+				fail();
+			}
+			scan(pScanner);
+		}
+
+		void scan(DirectoryScanner* pScanner)
+		{
+			try
+			{
+				std::vector<DirectoryScanner::Entry> batch;
+				while (pScanner && !_failed.load(std::memory_order_relaxed) && pScanner->next(batch))
+				{
+					for (std::size_t i = 0; i < batch.size(); ++i)
+					{
+						_visitor(pScanner->path(), batch[i]);
+						if (batch[i].type == DirectoryScanner::TYPE_DIRECTORY)
+							schedule(pScanner->path() + "/" + batch[i].name);
+					}
+				}
+			}
+			catch (...)
+			{
+				fail();
+			}
+			delete pScanner;
+			if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				_done.set();
+		}
+
+		void fail()
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_pError) _pError = std::current_exception();
+			_failed.store(true, std::memory_order_relaxed);
+		}
+
+		const DirectoryScanner::Visitor& _visitor;
+		ThreadPool&                      _pool;
+		std::atomic<int>                 _pending;
+		std::atomic<bool>                _failed;
+		std::mutex                       _mutex;
+		std::exception_ptr               _pError;
+		Event                            _done;
+	};
+}
+
+
+DirectoryScanner::DirectoryScanner(const std::string& path, std::size_t bufferSize):
+	_path(path),
+	_fd(-1),
+	_buffer(bufferSize)
+{
+	while (_path.size() > 1 && _path[_path.size() - 1] == '/')
+		_path.resize(_path.size() - 1);
+
+	_fd = ::open(_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (_fd == -1) File::handleLastError(_path);
+}
+
+
+DirectoryScanner::~DirectoryScanner()
+{
+	if (_fd != -1) ::close(_fd);
+}
+
+
+bool DirectoryScanner::next(std::vector<Entry>& entries)
+{
+	entries.clear();
+	while (entries.empty())
+	{
+		long n = ::syscall(SYS_getdents64, _fd, &_buffer[0], _buffer.size());
+		if (n < 0)
+		{
+			if (errno == EINTR) continue;
+			File::handleLastError(_path);
+		}
+		if (n == 0) return false;
+
+		for (long pos = 0; pos < n; )
+		{
+			const LinuxDirent64* pDirent = reinterpret_cast<const LinuxDirent64*>(&_buffer[pos]);
+			pos += pDirent->d_reclen;
+
+			const char* name = pDirent->d_name;
+			if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+				continue;
+
+			Entry entry;
+			entry.name = name;
+			entry.type = typeFromDirent(pDirent->d_type);
+			entry.inode = pDirent->d_ino;
+			if (entry.type == TYPE_UNKNOWN)
+			{
+				struct stat st;
+				if (::fstatat(_fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0)
+					entry.type = typeFromMode(st.st_mode);
+			}
+			entries.push_back(entry);
+		}
+	}
+	return true;
+}
+
+
+std::vector<DirectoryScanner::Entry> DirectoryScanner::list(const std::string& path)
+{
+	DirectoryScanner scanner(path);
+	std::vector<Entry> result;
+	std::vector<Entry> batch;
+	while (scanner.next(batch))
+		result.insert(result.end(), batch.begin(), batch.end());
+	return result;
+}
+
+
+void DirectoryScanner::walk(const std::string& root, const Visitor& visitor, ThreadPool& pool)
+{
+	std::shared_ptr<TreeWalk> pWalk = std::make_shared<TreeWalk>(visitor, pool);
+	pWalk->run(root);
+}
+
+
+void DirectoryScanner::walk(const std::string& root, const Visitor& visitor)
+{
+	walk(root, visitor, ThreadPool::defaultPool());
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Types.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+class ThreadPool;
+
+
+// Lists a directory with getdents64(), many entries per system call, and
+// reports each entry's type from d_type, so no File, Path or stat() is
+// needed per entry. Only filesystems that leave d_type unknown cost an
+// fstatat() for those entries.
+//
+// walk() visits a whole tree, scanning every subdirectory as a separate
+// task on a ThreadPool. Meant for indexing large asset and replay trees;
+// DirectoryIterator remains the simple, File based interface.
+class DirectoryScanner
+{
+public:
+	enum EntryType
+	{
+		TYPE_UNKNOWN,
+		TYPE_FILE,
+		TYPE_DIRECTORY,
+		TYPE_LINK,
+		TYPE_OTHER
+	};
+
+	struct Entry
+	{
+		std::string name;
+		EntryType   type;
+		UInt64      inode;
+	};
+
+	// Called with the directory path and one of its entries.
+	typedef std::function<void(const std::string& directory, const Entry& entry)> Visitor;
+
+	explicit DirectoryScanner(const std::string& path, std::size_t bufferSize = 64 * 1024);
+
+	~DirectoryScanner();
+
+	// Replaces entries with the next batch, skipping "." and "..". Returns
+	// false once the directory is exhausted.
+	bool next(std::vector<Entry>& entries);
+
+	const std::string& path() const;
+
+	static std::vector<Entry> list(const std::string& path);
+
+	// Visits every entry below root, without following symbolic links.
+	// visitor runs concurrently on the pool's threads and must be thread
+	// safe. Subdirectories that vanish during the walk are skipped; any
+	// other error, or an exception thrown by visitor, stops the walk and
+	// is rethrown here once running scans have finished. Must not be
+	// called from a task running in the same pool.
+	static void walk(const std::string& root, const Visitor& visitor, ThreadPool& pool);
+
+	static void walk(const std::string& root, const Visitor& visitor);
+
+private:
+	DirectoryScanner();
+	DirectoryScanner(const DirectoryScanner&);
+	DirectoryScanner& operator = (const DirectoryScanner&);
+
+	std::string       _path;
+	int               _fd;
+	std::vector<char> _buffer;
+};
+
+
+//
+// inlines
+//
+inline const std::string& DirectoryScanner::path() const
+{
+	return _path;
+}
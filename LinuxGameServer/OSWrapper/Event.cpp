@@ -1,12 +1,19 @@
 #include "Event.h"
-#include <time.h>
-#include <sys/time.h>
-#include <errno.h>
+#include "Futex.h"
+#include "Clock.h"
 #include "BaseException.h"
 
+
+namespace
+{
+	const int SPIN_COUNT = 100;
+}
+
+
 Event::Event(EventType type)
 	: _auto(type == EVENT_AUTORESET)
-	, _state(false)
+	, _state(0)
+	, _waiters(0)
 {
 }
 
@@ -15,52 +22,70 @@ Event::~Event()
 {
 }
 
- void Event::set()
+void Event::set()
 {
-	 std::unique_lock<std::mutex> lock(_mutex);
-	 _cond.notify_all();
+	_state.store(1, std::memory_order_seq_cst);
+	if (_waiters.load(std::memory_order_seq_cst) > 0)
+	{
+		if (_auto)
+			Futex::wake(_state, 1);
+		else
+			Futex::wakeAll(_state);
+	}
 }
 
- void Event::wait()
+bool Event::tryAcquire()
 {
-	 std::unique_lock<std::mutex> lock(_mutex);
-	 while (!_state)
-	 {
-		 _cond.wait(lock);
-	 }
-	 //_cond.wait(lock, [this] {return _state; });
-
-	if (_auto) _state = false;
+	if (!_auto) return _state.load(std::memory_order_acquire) == 1;
+
+	int state = 1;
+	return _state.load(std::memory_order_relaxed) == 1 && _state.compare_exchange_strong(state, 0, std::memory_order_acquire);
+}
+
+void Event::wait()
+{
+	for (int i = 0; i < SPIN_COUNT; ++i)
+	{
+		if (tryAcquire()) return;
+		Futex::pause();
+	}
+	while (!tryAcquire())
+	{
+		_waiters.fetch_add(1, std::memory_order_seq_cst);
+		Futex::wait(_state, 0);
+		_waiters.fetch_sub(1, std::memory_order_relaxed);
+	}
 }
 
 
- void Event::wait(long milliseconds)
+void Event::wait(long milliseconds)
 {
 	if (!tryWait(milliseconds))
 		throw TimeoutException();
 }
 
- bool Event::tryWait(long milliseconds)
+bool Event::tryWait(long milliseconds)
 {
-	auto rc = std::cv_status::no_timeout;
-	std::unique_lock<std::mutex> lock(_mutex);
+	for (int i = 0; i < SPIN_COUNT; ++i)
+	{
+		if (tryAcquire()) return true;
+		Futex::pause();
+	}
 
-	auto timeout_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
-	while (!_state)
+	Int64 deadline = Clock::monotonicNanoseconds() / 1000000 + milliseconds;
+	while (!tryAcquire())
 	{
-		if (_cond.wait_until(lock, timeout_time) == std::cv_status::timeout)
-		{
-			break;
-		}
+		long remaining = static_cast<long>(deadline - Clock::monotonicNanoseconds() / 1000000);
+		if (remaining <= 0) return false;
+		_waiters.fetch_add(1, std::memory_order_seq_cst);
+		Futex::wait(_state, 0, remaining);
+		_waiters.fetch_sub(1, std::memory_order_relaxed);
 	}
-	
-	if (rc == std::cv_status::no_timeout && _auto) _state = false;
-	return rc == std::cv_status::no_timeout;
+	return true;
 }
 
 
- void Event::reset()
+void Event::reset()
 {
-	 std::unique_lock<std::mutex> lock(_mutex);
-	_state = false;
+	_state.store(0, std::memory_order_relaxed);
 }
@@ -1,10 +1,11 @@
 #pragma once
 
-#include <condition_variable>
-#include <mutex>
 #include <atomic>
 
 
+// Event on a futex word holding 1 when set and 0 otherwise. Waiters spin
+// briefly, then register in a waiter count and park on the word; set() only
+// enters the kernel when that count is non-zero.
 class Event
 {
 public:
@@ -32,10 +33,11 @@ private:
 	Event(const Event&);
 	Event& operator = (const Event&);
 
+	bool tryAcquire();
+
 private:
-	std::atomic_bool  _auto;
-	std::atomic_bool  _state;
-	std::mutex  _mutex;
-	std::condition_variable  _cond;
+	bool              _auto;
+	std::atomic<int>  _state;
+	std::atomic<int>  _waiters;
 };
 
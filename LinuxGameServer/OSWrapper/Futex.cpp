@@ -0,0 +1,55 @@
+#include "Futex.h"
+#include <climits>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+
+namespace
+{
+	bool futexWait(std::atomic<int>& word, int op, int expected, long milliseconds)
+	{
+		struct timespec ts;
+		struct timespec* pTimeout = nullptr;
+		if (milliseconds >= 0)
+		{
+			ts.tv_sec = milliseconds / 1000;
+			ts.tv_nsec = (milliseconds % 1000) * 1000000;
+			pTimeout = &ts;
+		}
+		long rc = ::syscall(SYS_futex, reinterpret_cast<int*>(&word), op, expected, pTimeout, nullptr, 0);
+		return rc == 0 || errno != ETIMEDOUT;
+	}
+}
+
+
+bool Futex::wait(std::atomic<int>& word, int expected, long milliseconds)
+{
+	return futexWait(word, FUTEX_WAIT_PRIVATE, expected, milliseconds);
+}
+
+
+void Futex::wake(std::atomic<int>& word, int count)
+{
+	::syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+
+void Futex::wakeAll(std::atomic<int>& word)
+{
+	wake(word, INT_MAX);
+}
+
+
+bool Futex::waitShared(std::atomic<int>& word, int expected, long milliseconds)
+{
+	return futexWait(word, FUTEX_WAIT, expected, milliseconds);
+}
+
+
+void Futex::wakeShared(std::atomic<int>& word, int count)
+{
+	::syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
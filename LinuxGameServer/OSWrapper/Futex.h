@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+
+
+// Thin wrapper over the futex(2) system call. The plain calls are for
+// process private words; the shared ones for words in memory mapped by
+// several processes, such as a SharedMemory segment.
+class Futex
+{
+public:
+	// Sleeps while word holds expected. A negative timeout waits forever.
+	// Returns false only on timeout; spurious wakeups return true.
+	static bool wait(std::atomic<int>& word, int expected, long milliseconds = -1);
+
+	static void wake(std::atomic<int>& word, int count);
+
+	static void wakeAll(std::atomic<int>& word);
+
+	static bool waitShared(std::atomic<int>& word, int expected, long milliseconds = -1);
+
+	static void wakeShared(std::atomic<int>& word, int count);
+
+	// CPU hint for spin loops.
+	static void pause();
+};
+
+
+//
+// inlines
+//
+inline void Futex::pause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	asm volatile("yield");
+#endif
+}
@@ -0,0 +1,61 @@
+#include "Latch.h"
+#include "Futex.h"
+#include "Clock.h"
+#include "Bugcheck.h"
+
+
+Latch::Latch(int count):
+	_count(count),
+	_waiters(0)
+{
+	ASSERT(count >= 0);
+}
+
+
+Latch::~Latch()
+{
+}
+
+
+void Latch::countDown(int n)
+{
+	int count = _count.fetch_sub(n, std::memory_order_seq_cst) - n;
+	ASSERT(count >= 0);
+	if (count == 0 && _waiters.load(std::memory_order_seq_cst) > 0)
+		Futex::wakeAll(_count);
+}
+
+
+void Latch::wait()
+{
+	int count;
+	while ((count = _count.load(std::memory_order_acquire)) != 0)
+	{
+		_waiters.fetch_add(1, std::memory_order_seq_cst);
+		Futex::wait(_count, count);
+		_waiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+
+bool Latch::tryWait(long milliseconds)
+{
+	Int64 deadline = Clock::monotonicNanoseconds() / 1000000 + milliseconds;
+	int count;
+	while ((count = _count.load(std::memory_order_acquire)) != 0)
+	{
+		long remaining = static_cast<long>(deadline - Clock::monotonicNanoseconds() / 1000000);
+		if (remaining <= 0) return false;
+		_waiters.fetch_add(1, std::memory_order_seq_cst);
+		Futex::wait(_count, count, remaining);
+		_waiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return true;
+}
+
+
+void Latch::arriveAndWait(int n)
+{
+	countDown(n);
+	wait();
+}
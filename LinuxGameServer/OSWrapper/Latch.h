@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+
+
+// Single use countdown: wait() blocks until countDown() has been called
+// count times in total.
+class Latch
+{
+public:
+	explicit Latch(int count);
+
+	~Latch();
+
+	void countDown(int n = 1);
+
+	bool tryWait() const;
+
+	void wait();
+
+	bool tryWait(long milliseconds);
+
+	// Counts down and waits for the others.
+	void arriveAndWait(int n = 1);
+
+private:
+	Latch();
+	Latch(const Latch&);
+	Latch& operator = (const Latch&);
+
+	std::atomic<int> _count;
+	std::atomic<int> _waiters;
+};
+
+
+//
+// inlines
+//
+inline bool Latch::tryWait() const
+{
+	return _count.load(std::memory_order_acquire) == 0;
+}
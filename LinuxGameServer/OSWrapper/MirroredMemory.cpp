@@ -0,0 +1,75 @@
+#include "MirroredMemory.h"
+#include "BaseException.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+namespace
+{
+	int createMemfd(const char* name)
+	{
+#if defined(SYS_memfd_create)
+		return static_cast<int>(::syscall(SYS_memfd_create, name, MFD_CLOEXEC));
+#else
+		return ::memfd_create(name, MFD_CLOEXEC);
+#endif
+	}
+}
+
+
+char* MirroredMemory::map(std::size_t size)
+{
+	if (size == 0 || size % pageSize() != 0)
+		throw InvalidArgumentException("Mirrored memory size must be a multiple of the page size");
+
+	int fd = createMemfd("MirroredMemory");
+	if (fd == -1)
+		throw SystemException("Cannot create memfd for mirrored memory");
+
+	if (::ftruncate(fd, static_cast<off_t>(size)) == -1)
+	{
+		::close(fd);
+		throw SystemException("Cannot size memfd for mirrored memory");
+	}
+
+	void* base = ::mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED)
+	{
+		::close(fd);
+		throw SystemException("Cannot reserve address space for mirrored memory");
+	}
+
+	char* address = static_cast<char*>(base);
+	if (::mmap(address, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+		::mmap(address + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+	{
+		::munmap(base, 2 * size);
+		::close(fd);
+		throw SystemException("Cannot map mirrored memory");
+	}
+
+	::close(fd);
+	return address;
+}
+
+
+void MirroredMemory::unmap(char* address, std::size_t size)
+{
+	if (address) ::munmap(address, 2 * size);
+}
+
+
+std::size_t MirroredMemory::pageSize()
+{
+	static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+	return size;
+}
+
+
+std::size_t MirroredMemory::roundUp(std::size_t size)
+{
+	std::size_t page = pageSize();
+	return (size + page - 1) / page * page;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+
+// Maps the same memfd pages twice, back to back, so that a ring buffer of
+// size bytes can be read and written across its end as one contiguous range.
+// size must be a multiple of pageSize().
+class MirroredMemory
+{
+public:
+	static char* map(std::size_t size);
+
+	static void unmap(char* address, std::size_t size);
+
+	static std::size_t pageSize();
+
+	static std::size_t roundUp(std::size_t size);
+};
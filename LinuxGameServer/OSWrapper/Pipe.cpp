@@ -2,8 +2,16 @@
 #include "BaseException.h"
 #include "Bugcheck.h"
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <string>
+#include <utility>
+
+
+static_assert(sizeof(off_t) == sizeof(loff_t), "splice offsets need a 64-bit off_t");
+
 
 Pipe::Pipe()
 {
@@ -18,9 +26,17 @@ Pipe::Pipe()
 }
 
 
-Pipe::Pipe(const Pipe& pipe)
+Pipe::Pipe(const Pipe& pipe):
+	_readfd(-1),
+	_writefd(-1)
 {
-	*this = pipe;
+	if (pipe._readfd != -1 && (_readfd = ::dup(pipe._readfd)) == -1)
+		throw CreateFileException("anonymous pipe");
+	if (pipe._writefd != -1 && (_writefd = ::dup(pipe._writefd)) == -1)
+	{
+		closeRead();
+		throw CreateFileException("anonymous pipe");
+	}
 }
 
 
@@ -35,7 +51,9 @@ Pipe& Pipe::operator = (const Pipe& pipe)
 {
 	if (this != &pipe)
 	{
-		*this = pipe;
+		Pipe tmp(pipe);
+		std::swap(_readfd, tmp._readfd);
+		std::swap(_writefd, tmp._writefd);
 	}
 	return *this;
 }
@@ -90,6 +108,103 @@ ssize_t Pipe::readBytes(void* buffer, int length)
 }
 
 
+ssize_t Pipe::spliceFrom(int fd, std::size_t length, off_t* pOffset)
+{
+	ASSERT(_writefd != -1);
+
+	ssize_t n;
+	do
+	{
+		n = ::splice(fd, reinterpret_cast<loff_t*>(pOffset), _writefd, 0, length, SPLICE_F_MOVE);
+	} while (n < 0 && errno == EINTR);
+	if (n >= 0)
+		return n;
+	else
+		throw WriteFileException("anonymous pipe");
+}
+
+
+ssize_t Pipe::spliceTo(int fd, std::size_t length, off_t* pOffset)
+{
+	ASSERT(_readfd != -1);
+
+	ssize_t n;
+	do
+	{
+		n = ::splice(_readfd, 0, fd, reinterpret_cast<loff_t*>(pOffset), length, SPLICE_F_MOVE);
+	} while (n < 0 && errno == EINTR);
+	if (n >= 0)
+		return n;
+	else
+		throw ReadFileException("anonymous pipe");
+}
+
+
+ssize_t Pipe::vmspliceFrom(const struct iovec* iov, int count)
+{
+	ASSERT(_writefd != -1);
+
+	ssize_t n;
+	do
+	{
+		n = ::vmsplice(_writefd, iov, count, 0);
+	} while (n < 0 && errno == EINTR);
+	if (n >= 0)
+		return n;
+	else
+		throw WriteFileException("anonymous pipe");
+}
+
+
+ssize_t Pipe::vmspliceFrom(const void* buffer, std::size_t length)
+{
+	struct iovec iov;
+	iov.iov_base = const_cast<void*>(buffer);
+	iov.iov_len = length;
+	return vmspliceFrom(&iov, 1);
+}
+
+
+ssize_t Pipe::tee(const Pipe& source, const Pipe& target, std::size_t length)
+{
+	ASSERT(source._readfd != -1 && target._writefd != -1);
+
+	ssize_t n;
+	do
+	{
+		n = ::tee(source._readfd, target._writefd, length, 0);
+	} while (n < 0 && errno == EINTR);
+	if (n >= 0)
+		return n;
+	else
+		throw WriteFileException("anonymous pipe");
+}
+
+
+int Pipe::capacity() const
+{
+	int fd = _readfd != -1 ? _readfd : _writefd;
+	ASSERT(fd != -1);
+
+	int n = ::fcntl(fd, F_GETPIPE_SZ);
+	if (n < 0)
+		throw SystemException("cannot get pipe size");
+	return n;
+}
+
+
+int Pipe::setCapacity(int bytes)
+{
+	int fd = _readfd != -1 ? _readfd : _writefd;
+	ASSERT(fd != -1);
+
+	int n = ::fcntl(fd, F_SETPIPE_SZ, bytes);
+	if (n < 0)
+		throw SystemException("cannot set pipe size", std::to_string(bytes));
+	return n;
+}
+
+
 Pipe::Handle Pipe::readHandle() const
 {
 	return _readfd;
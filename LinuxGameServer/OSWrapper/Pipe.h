@@ -1,6 +1,9 @@
 #pragma once
 
 #include <sys/types.h>
+#include <cstddef>
+
+struct iovec;
 
 class Pipe
 {
@@ -24,6 +27,32 @@ public:
 
 	ssize_t readBytes(void* buffer, int length);
 
+	// Zero-copy transfers. The splice calls move up to length bytes between
+	// the pipe and fd (a file, socket or another pipe) inside the kernel;
+	// pOffset, if given, is the file position to use and is advanced
+	// instead of fd's own. They return the number of bytes moved, 0 at end
+	// of input.
+	ssize_t spliceFrom(int fd, std::size_t length, off_t* pOffset = 0);
+
+	ssize_t spliceTo(int fd, std::size_t length, off_t* pOffset = 0);
+
+	// Maps user pages into the pipe instead of copying them. The memory must
+	// stay unchanged until the reader has consumed it.
+	ssize_t vmspliceFrom(const struct iovec* iov, int count);
+
+	ssize_t vmspliceFrom(const void* buffer, std::size_t length);
+
+	// Duplicates up to length bytes waiting in source into target without
+	// consuming them from source.
+	static ssize_t tee(const Pipe& source, const Pipe& target, std::size_t length);
+
+	// Kernel buffer size in bytes. setCapacity() rounds up to a page
+	// multiple and returns the size granted; unprivileged processes are
+	// limited by /proc/sys/fs/pipe-max-size.
+	int capacity() const;
+
+	int setCapacity(int bytes);
+
 	Handle readHandle() const;
 
 	Handle writeHandle() const;
@@ -100,6 +100,15 @@ public:
 	static void requestTermination(PID pid);
 
 private:
+	static ProcessHandle launchBySpawn(
+		const std::string& command,
+		const Args& args,
+		const std::string& initialDirectory,
+		Pipe* inPipe,
+		Pipe* outPipe,
+		Pipe* errPipe,
+		const Env& env);
+
 	static ProcessHandle launchByForkExec(
 		const std::string& command,
 		const Args& args,
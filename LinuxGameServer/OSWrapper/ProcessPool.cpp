@@ -0,0 +1,249 @@
+#include "ProcessPool.h"
+#include "Pipe.h"
+#include "BaseException.h"
+#include "Bugcheck.h"
+#include "Types.h"
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <unistd.h>
+
+
+namespace
+{
+	// Writing to a worker that has died raises SIGPIPE, which would kill
+	// the server. Block it around the write and swallow the one our write
+	// raised, without touching the process-wide disposition.
+	class SigPipeGuard
+	{
+	public:
+		SigPipeGuard()
+		{
+			sigset_t pending;
+			sigemptyset(&_set);
+			sigaddset(&_set, SIGPIPE);
+			sigpending(&pending);
+			_pending = sigismember(&pending, SIGPIPE);
+			pthread_sigmask(SIG_BLOCK, &_set, &_old);
+		}
+
+		~SigPipeGuard()
+		{
+			if (!_pending)
+			{
+				struct timespec zero = {0, 0};
+				while (sigtimedwait(&_set, 0, &zero) == -1 && errno == EINTR)
+				{
+				}
+			}
+			pthread_sigmask(SIG_SETMASK, &_old, 0);
+		}
+
+	private:
+		sigset_t _set;
+		sigset_t _old;
+		int      _pending;
+	};
+
+
+	bool readFully(int fd, char* buffer, std::size_t length)
+	{
+		std::size_t done = 0;
+		while (done < length)
+		{
+			ssize_t n = ::read(fd, buffer + done, length - done);
+			if (n > 0)
+				done += static_cast<std::size_t>(n);
+			else if (n == 0)
+				return false;
+			else if (errno != EINTR)
+				throw ReadFileException("process pool pipe");
+		}
+		return true;
+	}
+
+
+	void writeFully(int fd, const char* buffer, std::size_t length)
+	{
+		std::size_t done = 0;
+		while (done < length)
+		{
+			ssize_t n = ::write(fd, buffer + done, length - done);
+			if (n >= 0)
+				done += static_cast<std::size_t>(n);
+			else if (errno != EINTR)
+				throw WriteFileException("process pool pipe");
+		}
+	}
+}
+
+
+struct ProcessPool::Worker
+{
+	Worker():
+		pid(0)
+	{
+	}
+
+	Pipe               in;
+	Pipe               out;
+	ProcessHandle::PID pid;		///< 0 while not running
+};
+
+
+ProcessPool::ProcessPool(const std::string& command, const Process::Args& args, int workers, const std::string& name):
+	_command(command),
+	_args(args),
+	_name(name),
+	_available(workers > 0 ? workers : 1)
+{
+	if (workers <= 0)
+		throw InvalidArgumentException("process pool needs at least one worker", _name);
+
+	try
+	{
+		for (int i = 0; i < workers; ++i)
+		{
+			_workers.push_back(new Worker);
+			launch(_workers.back());
+			_idle.push_back(_workers.back());
+		}
+	}
+	catch (...)
+	{
+		for (std::size_t i = 0; i < _workers.size(); ++i)
+		{
+			retire(_workers[i]);
+			delete _workers[i];
+		}
+		throw;
+	}
+}
+
+
+ProcessPool::~ProcessPool()
+{
+	// every worker sees end of input first, so they exit in parallel
+	for (std::size_t i = 0; i < _workers.size(); ++i)
+		_workers[i]->in.close(Pipe::CLOSE_WRITE);
+	for (std::size_t i = 0; i < _workers.size(); ++i)
+	{
+		retire(_workers[i]);
+		delete _workers[i];
+	}
+}
+
+
+std::string ProcessPool::execute(const std::string& job)
+{
+	if (job.size() > MAX_FRAME)
+		throw InvalidArgumentException("process pool job too large", _name);
+
+	Worker* pWorker = acquire();
+	std::string result;
+	try
+	{
+		if (!pWorker->pid) launch(pWorker);
+		{
+			SigPipeGuard guard;
+			writeFrame(pWorker->in.writeHandle(), job);
+		}
+		if (!readFrame(pWorker->out.readHandle(), result))
+			throw IOException("process pool worker exited", _name);
+	}
+	catch (Exception& exc)
+	{
+		retire(pWorker);
+		release(pWorker);
+		throw IOException("process pool worker failed", _name + ": " + exc.displayText());
+	}
+	catch (...)
+	{
+		retire(pWorker);
+		release(pWorker);
+		throw;
+	}
+	release(pWorker);
+	return result;
+}
+
+
+ProcessPool::Worker* ProcessPool::acquire()
+{
+	_available.wait();
+	std::lock_guard<std::mutex> lock(_mutex);
+	ASSERT(!_idle.empty());
+	// LIFO keeps the most recently used, warmest workers busy
+	Worker* pWorker = _idle.back();
+	_idle.pop_back();
+	return pWorker;
+}
+
+
+void ProcessPool::release(Worker* pWorker)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_idle.push_back(pWorker);
+	}
+	_available.set();
+}
+
+
+void ProcessPool::launch(Worker* pWorker)
+{
+	Pipe in;
+	Pipe out;
+	ProcessHandle handle = Process::launch(_command, _args, &in, &out, 0);
+	pWorker->in = in;
+	pWorker->out = out;
+	pWorker->pid = handle.id();
+}
+
+
+void ProcessPool::retire(Worker* pWorker)
+{
+	pWorker->in.close();
+	pWorker->out.close();
+	if (!pWorker->pid) return;
+
+	ProcessHandle handle(pWorker->pid);
+	pWorker->pid = 0;
+	try
+	{
+		// a worker that ignores end of input would block the pool forever
+		for (int i = 0; i < 100 && handle.tryWait() < 0; ++i)
+			::usleep(10000);
+		if (Process::isRunning(handle))
+		{
+			Process::kill(handle);
+			handle.wait();
+		}
+	}
+	catch (Exception&)
+	{
+	}
+}
+
+
+bool ProcessPool::readFrame(int fd, std::string& frame)
+{
+	UInt32 length;
+	if (!readFully(fd, reinterpret_cast<char*>(&length), sizeof(length)))
+		return false;
+	if (length > MAX_FRAME)
+		throw DataFormatException("process pool frame too large");
+	frame.resize(length);
+	if (length && !readFully(fd, &frame[0], length))
+		throw ReadFileException("process pool frame truncated");
+	return true;
+}
+
+
+void ProcessPool::writeFrame(int fd, const std::string& frame)
+{
+	ASSERT(frame.size() <= MAX_FRAME);
+	UInt32 length = static_cast<UInt32>(frame.size());
+	writeFully(fd, reinterpret_cast<const char*>(&length), sizeof(length));
+	writeFully(fd, frame.data(), frame.size());
+}
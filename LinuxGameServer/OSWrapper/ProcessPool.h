@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Process.h"
+#include "Semaphore.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// Fixed set of pre-launched helper processes for isolated, CPU heavy work
+// (script sandboxes, map baking, report generation), so a job pays for a
+// pipe round trip instead of spawn, exec and warm-up.
+//
+// Every worker runs command with its stdin and stdout connected to the
+// pool. Jobs and results travel as frames: a native UInt32 length followed
+// by that many bytes. A worker handles one job at a time, reads the whole
+// job before it starts writing, and answers with exactly one result frame;
+// serve() implements that loop on the worker side. Worker stdout carries
+// only frames, so diagnostics must go to stderr, which is inherited.
+//
+// execute() hands the job to an idle worker, blocking while all are busy,
+// and may be called from any number of threads. A worker that dies or
+// breaks the protocol fails the job with an IOException and is relaunched
+// for the next one.
+class ProcessPool
+{
+public:
+	ProcessPool(const std::string& command, const Process::Args& args, int workers, const std::string& name = "process-pool");
+
+	// Closes the workers' input and waits for them to exit.
+	~ProcessPool();
+
+	std::string execute(const std::string& job);
+
+	int capacity() const;
+
+	const std::string& name() const;
+
+	// Worker side: answers every job read from stdin with handler(job) on
+	// stdout until the pool closes the pipe. Returns the process exit code.
+	template <class Handler>
+	static int serve(Handler handler);
+
+	// Frame I/O on raw descriptors. readFrame() returns false at end of
+	// input before a frame starts.
+	static bool readFrame(int fd, std::string& frame);
+
+	static void writeFrame(int fd, const std::string& frame);
+
+	static const std::size_t MAX_FRAME = 256 * 1024 * 1024;
+
+private:
+	ProcessPool();
+	ProcessPool(const ProcessPool&);
+	ProcessPool& operator = (const ProcessPool&);
+
+	struct Worker;
+
+	Worker* acquire();
+	void release(Worker* pWorker);
+	void launch(Worker* pWorker);
+	void retire(Worker* pWorker);
+
+	std::string          _command;
+	Process::Args        _args;
+	std::string          _name;
+	std::vector<Worker*> _workers;
+	std::vector<Worker*> _idle;
+	std::mutex           _mutex;
+	Semaphore            _available;
+};
+
+
+//
+// inlines
+//
+inline int ProcessPool::capacity() const
+{
+	return static_cast<int>(_workers.size());
+}
+
+
+inline const std::string& ProcessPool::name() const
+{
+	return _name;
+}
+
+
+template <class Handler>
+int ProcessPool::serve(Handler handler)
+{
+	std::string job;
+	while (readFrame(0, job))
+		writeFrame(1, handler(job));
+	return 0;
+}
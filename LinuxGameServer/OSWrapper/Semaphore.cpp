@@ -0,0 +1,94 @@
+#include "Semaphore.h"
+#include "Futex.h"
+#include "Clock.h"
+#include "BaseException.h"
+#include "Bugcheck.h"
+#include <climits>
+
+
+namespace
+{
+	const int SPIN_COUNT = 100;
+}
+
+
+Semaphore::Semaphore(int n):
+	_count(n),
+	_waiters(0),
+	_max(INT_MAX)
+{
+	ASSERT(n >= 0);
+}
+
+
+Semaphore::Semaphore(int n, int max):
+	_count(n),
+	_waiters(0),
+	_max(max)
+{
+	ASSERT(n >= 0 && max > 0 && n <= max);
+}
+
+
+Semaphore::~Semaphore()
+{
+}
+
+
+void Semaphore::set()
+{
+	int count = _count.load(std::memory_order_relaxed);
+	do
+	{
+		if (count >= _max)
+			throw SystemException("cannot signal semaphore: count would exceed maximum");
+	}
+	while (!_count.compare_exchange_weak(count, count + 1, std::memory_order_seq_cst, std::memory_order_relaxed));
+
+	if (_waiters.load(std::memory_order_seq_cst) > 0)
+		Futex::wake(_count, 1);
+}
+
+
+void Semaphore::wait()
+{
+	for (int i = 0; i < SPIN_COUNT; ++i)
+	{
+		if (tryAcquire()) return;
+		Futex::pause();
+	}
+	while (!tryAcquire())
+	{
+		_waiters.fetch_add(1, std::memory_order_seq_cst);
+		Futex::wait(_count, 0);
+		_waiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+
+void Semaphore::wait(long milliseconds)
+{
+	if (!tryWait(milliseconds))
+		throw TimeoutException();
+}
+
+
+bool Semaphore::tryWait(long milliseconds)
+{
+	for (int i = 0; i < SPIN_COUNT; ++i)
+	{
+		if (tryAcquire()) return true;
+		Futex::pause();
+	}
+
+	Int64 deadline = Clock::monotonicNanoseconds() / 1000000 + milliseconds;
+	while (!tryAcquire())
+	{
+		long remaining = static_cast<long>(deadline - Clock::monotonicNanoseconds() / 1000000);
+		if (remaining <= 0) return false;
+		_waiters.fetch_add(1, std::memory_order_seq_cst);
+		Futex::wait(_count, 0, remaining);
+		_waiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return true;
+}
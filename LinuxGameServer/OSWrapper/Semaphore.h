@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+
+
+// Counting semaphore on a futex word. wait() decrements the count, blocking
+// while it is zero; set() increments it and wakes one waiter if any.
+class Semaphore
+{
+public:
+	Semaphore(int n);
+
+	Semaphore(int n, int max);
+
+	~Semaphore();
+
+	void set();
+
+	void wait();
+
+	void wait(long milliseconds);
+
+	bool tryWait(long milliseconds);
+
+	bool tryAcquire();
+
+private:
+	Semaphore();
+	Semaphore(const Semaphore&);
+	Semaphore& operator = (const Semaphore&);
+
+	std::atomic<int> _count;
+	std::atomic<int> _waiters;
+	int              _max;
+};
+
+
+//
+// inlines
+//
+inline bool Semaphore::tryAcquire()
+{
+	int count = _count.load(std::memory_order_relaxed);
+	while (count > 0)
+	{
+		if (_count.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed))
+			return true;
+	}
+	return false;
+}
@@ -1,5 +1,6 @@
 #include "SharedMemory.h"
 #include "BaseException.h"
+#include "File.h"
 
 #include <sys/types.h>
 #include <sys/ipc.h>
@@ -8,6 +9,8 @@
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <cstdlib>
+#include <fstream>
 
 
 /*
@@ -24,26 +27,184 @@ int shmctl(int shmid, int cmd, struct shmid_ds *buf);
 */
 
 
-SharedMemory::SharedMemory(const std::string& name, std::size_t size, SharedMemory::AccessMode mode, const void* addrHint, bool server) :
+namespace
+{
+	const char* const HUGETLBFS_MOUNT = "/dev/hugepages";
+
+	std::size_t roundUp(std::size_t size, std::size_t unit)
+	{
+		return (size + unit - 1) / unit * unit;
+	}
+}
+
+
+SharedMemory::SharedMemory(const std::string& name, std::size_t size, SharedMemory::AccessMode mode, const void* addrHint, bool server, int options) :
 	_size(size),
 	_fd(-1),
 	_address(0),
 	_access(mode),
 	_name("/"),
 	_fileMapped(false),
-	_server(server)
+	_server(server),
+	_options(options)
+{
+	if (_options & OPT_HUGE_PAGES)
+	{
+		// hugetlbfs files need a page multiple; shm_open cannot give huge pages
+		_name = HUGETLBFS_MOUNT + _name;
+		_size = roundUp(_size, hugePageSize());
+	}
+	_name.append(name);
+
+	int flags = _server ? O_CREAT : 0;
+	if (_access == SharedMemory::AM_WRITE)
+		flags |= O_RDWR;
+	else
+		flags |= O_RDONLY;
+
+	if (_options & OPT_HUGE_PAGES)
+		_fd = ::open(_name.c_str(), flags | O_CLOEXEC, S_IRUSR | S_IWUSR);
+	else
+		_fd = ::shm_open(_name.c_str(), flags, S_IRUSR | S_IWUSR);
+	if (-1 == _fd)
+		throw SystemException("Cannot create shared memory object", _name);
+
+	try
+	{
+		if (_server)
+		{
+			if (-1 == ::ftruncate(_fd, static_cast<off_t>(_size)))
+				throw SystemException("Cannot resize shared memory object", _name);
+		}
+		else if (_size == 0)
+		{
+			// a client passing no size maps whatever the server created
+			struct stat st;
+			if (-1 == ::fstat(_fd, &st))
+				throw SystemException("Cannot stat shared memory object", _name);
+			_size = static_cast<std::size_t>(st.st_size);
+		}
+		map(addrHint);
+	}
+	catch (...)
+	{
+		close();
+		throw;
+	}
+}
+
+SharedMemory::SharedMemory(const File& file, SharedMemory::AccessMode mode, const void* addrHint, int options) :
+	_size(0),
+	_fd(-1),
+	_address(0),
+	_access(mode),
+	_name(file.path()),
+	_fileMapped(true),
+	_server(false),
+	_options(options)
 {
+	if (_options & OPT_HUGE_PAGES)
+		throw InvalidArgumentException("Huge pages need a hugetlbfs or memfd segment", _name);
+
+	int flag = O_RDONLY;
+	if (mode == SharedMemory::AM_WRITE)
+		flag = O_RDWR;
+	_fd = ::open(_name.c_str(), flag);
+	if (-1 == _fd)
+		throw OpenFileException("Cannot open memory mapped file", _name);
 
+	_size = static_cast<std::size_t>(file.getSize());
+	if (_size == 0) return;
+	try
+	{
+		map(addrHint);
+	}
+	catch (...)
+	{
+		close();
+		throw;
+	}
 }
 
-SharedMemory::SharedMemory(const SharedMemory& other) 
+SharedMemory::SharedMemory(int fd, const std::string& name, std::size_t size, SharedMemory::AccessMode mode, int options) :
+	_size(size),
+	_fd(fd),
+	_address(0),
+	_access(mode),
+	_name(name),
+	_fileMapped(false),
+	_server(false),
+	_options(options)
 {
-	*this = other;
+	try
+	{
+		if (_size == 0)
+		{
+			struct stat st;
+			if (-1 == ::fstat(_fd, &st))
+				throw SystemException("Cannot stat shared memory object", _name);
+			_size = static_cast<std::size_t>(st.st_size);
+		}
+		else if (-1 == ::ftruncate(_fd, static_cast<off_t>(_size)))
+		{
+			throw SystemException("Cannot resize shared memory object", _name);
+		}
+		if (_size != 0) map(0);
+	}
+	catch (...)
+	{
+		close();
+		throw;
+	}
+}
+
+SharedMemory::SharedMemory() :
+	_size(0),
+	_fd(-1),
+	_address(0),
+	_access(SharedMemory::AM_READ),
+	_fileMapped(false),
+	_server(false),
+	_options(OPT_NONE)
+{
+}
+
+// A copy maps the same object again through a duplicated descriptor. Only
+// the original unlinks a named object it created.
+SharedMemory::SharedMemory(const SharedMemory& other) :
+	_size(other._size),
+	_fd(-1),
+	_address(0),
+	_access(other._access),
+	_name(other._name),
+	_fileMapped(other._fileMapped),
+	_server(false),
+	_options(other._options)
+{
+	if (other._fd == -1) return;
+
+	_fd = ::dup(other._fd);
+	if (-1 == _fd)
+		throw SystemException("Cannot duplicate shared memory descriptor", _name);
+	if (_size == 0) return;
+	try
+	{
+		map(0);
+	}
+	catch (...)
+	{
+		close();
+		throw;
+	}
 }
 
 SharedMemory& SharedMemory::operator = (const SharedMemory& other)
 {
-	*this = other;
+	if (this != &other)
+	{
+		SharedMemory tmp(other);
+		swap(tmp);
+	}
 	return *this;
 }
 
@@ -54,17 +215,78 @@ SharedMemory::~SharedMemory()
 }
 
 
+SharedMemory SharedMemory::anonymous(const std::string& name, std::size_t size, int options)
+{
+	unsigned flags = MFD_CLOEXEC;
+	if (options & OPT_HUGE_PAGES)
+	{
+		flags |= MFD_HUGETLB;
+		size = roundUp(size, hugePageSize());
+	}
+	int fd = ::memfd_create(name.c_str(), flags);
+	if (-1 == fd)
+		throw SystemException("Cannot create anonymous shared memory", name);
+	return SharedMemory(fd, name, size, SharedMemory::AM_WRITE, options);
+}
+
+
+SharedMemory SharedMemory::fromDescriptor(int fd, SharedMemory::AccessMode mode, int options)
+{
+	int dupFd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+	if (-1 == dupFd)
+		throw SystemException("Cannot duplicate shared memory descriptor", std::to_string(fd));
+	return SharedMemory(dupFd, "fd:" + std::to_string(fd), 0, mode, options);
+}
+
+
+std::size_t SharedMemory::hugePageSize()
+{
+	static std::size_t size = 0;
+	if (size == 0)
+	{
+		std::size_t found = 2 * 1024 * 1024;
+		std::ifstream istr("/proc/meminfo");
+		std::string line;
+		while (std::getline(istr, line))
+		{
+			if (line.compare(0, 13, "Hugepagesize:") == 0)
+			{
+				std::size_t kb = std::strtoul(line.c_str() + 13, 0, 10);
+				if (kb) found = kb * 1024;
+				break;
+			}
+		}
+		size = found;
+	}
+	return size;
+}
+
+
 void SharedMemory::map(const void* addrHint)
 {
 	int access = PROT_READ;
 	if (_access == SharedMemory::AM_WRITE)
 		access |= PROT_WRITE;
 
-	void* addr = ::mmap(const_cast<void*>(addrHint), _size, access, MAP_SHARED, _fd, 0);
+	int flags = MAP_SHARED;
+	if (_options & OPT_POPULATE)
+		flags |= MAP_POPULATE;
+
+	void* addr = ::mmap(const_cast<void*>(addrHint), _size, access, flags, _fd, 0);
 	if (addr == MAP_FAILED)
 		throw SystemException("Cannot map file into shared memory", _name);
 
 	_address = static_cast<char*>(addr);
+
+	// only a hint: fails on kernels built without THP
+	if (_options & OPT_TRANSPARENT_HUGE_PAGES)
+		::madvise(_address, _size, MADV_HUGEPAGE);
+
+	if ((_options & OPT_LOCK) && -1 == ::mlock(_address, _size))
+	{
+		unmap();
+		throw SystemException("Cannot lock shared memory", _name);
+	}
 }
 
 
@@ -73,6 +295,7 @@ void SharedMemory::unmap()
 	if (_address)
 	{
 		::munmap(_address, _size);
+		_address = 0;
 	}
 }
 
@@ -86,6 +309,9 @@ void SharedMemory::close()
 	}
 	if (!_fileMapped && _server)
 	{
-		::shm_unlink(_name.c_str());
+		if (_options & OPT_HUGE_PAGES)
+			::unlink(_name.c_str());
+		else
+			::shm_unlink(_name.c_str());
 	}
 }
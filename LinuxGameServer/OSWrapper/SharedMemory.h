@@ -1,6 +1,9 @@
 #pragma once
 
 #include <string>
+#include <utility>
+
+class File;
 
 class SharedMemory
 {
@@ -11,8 +14,31 @@ public:
 		AM_WRITE
 	};
 
+	// Mapping options, combined with |.
+	//  - OPT_HUGE_PAGES backs the segment with hugetlb pages: memfd regions
+	//    use MFD_HUGETLB, named ones live on the hugetlbfs mount instead of
+	//    /dev/shm. The size is rounded up to hugePageSize(), and the kernel
+	//    must have enough pages reserved (vm.nr_hugepages).
+	//  - OPT_TRANSPARENT_HUGE_PAGES asks for transparent huge pages with
+	//    madvise(); it is only a hint.
+	//  - OPT_POPULATE prefaults the whole mapping when it is created.
+	//  - OPT_LOCK keeps the mapping resident with mlock() and throws if
+	//    RLIMIT_MEMLOCK does not allow it.
+	enum Options
+	{
+		OPT_NONE                   = 0,
+		OPT_HUGE_PAGES             = 1,
+		OPT_TRANSPARENT_HUGE_PAGES = 2,
+		OPT_POPULATE               = 4,
+		OPT_LOCK                   = 8
+	};
+
 	SharedMemory();
-	SharedMemory(const std::string& name, std::size_t size, SharedMemory::AccessMode mode, const void* addrHint = 0, bool server = true);
+	SharedMemory(const std::string& name, std::size_t size, SharedMemory::AccessMode mode, const void* addrHint = 0, bool server = true, int options = OPT_NONE);
+	// Maps the file MAP_SHARED: writes by other processes show through, and
+	// touching pages past a truncated end raises SIGBUS. Only map files that
+	// do not change while mapped.
+	SharedMemory(const File& file, SharedMemory::AccessMode mode, const void* addrHint = 0, int options = OPT_NONE);
 	SharedMemory(const SharedMemory& other);
 	
 	~SharedMemory();
@@ -26,7 +52,27 @@ public:
 
 	char* end() const;
 
+	std::size_t size() const;
+
+	int options() const;
+
+	// Descriptor of the underlying object, for passing an anonymous segment
+	// to another process (inherited across fork or sent with SCM_RIGHTS).
+	int descriptor() const;
+
+	// Creates an unnamed writable segment with memfd_create(). name only
+	// labels it in /proc/<pid>/fd.
+	static SharedMemory anonymous(const std::string& name, std::size_t size, int options = OPT_NONE);
+
+	// Maps a segment from a descriptor received from another process. The
+	// descriptor is duplicated; the caller still owns fd.
+	static SharedMemory fromDescriptor(int fd, SharedMemory::AccessMode mode, int options = OPT_NONE);
+
+	static std::size_t hugePageSize();
+
 protected:
+	SharedMemory(int fd, const std::string& name, std::size_t size, SharedMemory::AccessMode mode, int options);
+
 	void map(const void* addrHint);
 
 	void unmap();
@@ -41,6 +87,7 @@ private:
 	std::string _name;
 	bool        _fileMapped;
 	bool        _server;
+	int         _options;
 };
 
 
@@ -55,7 +102,32 @@ inline char* SharedMemory::end() const
 	return _address + _size;
 }
 
+inline std::size_t SharedMemory::size() const
+{
+	return _size;
+}
+
+
+inline int SharedMemory::options() const
+{
+	return _options;
+}
+
+
+inline int SharedMemory::descriptor() const
+{
+	return _fd;
+}
+
+
 inline void SharedMemory::swap(SharedMemory& other)
 {
-	*this = other;
+	std::swap(_size, other._size);
+	std::swap(_fd, other._fd);
+	std::swap(_address, other._address);
+	std::swap(_access, other._access);
+	std::swap(_name, other._name);
+	std::swap(_fileMapped, other._fileMapped);
+	std::swap(_server, other._server);
+	std::swap(_options, other._options);
 }
@@ -0,0 +1,413 @@
+#include "SharedRing.h"
+#include "Futex.h"
+#include "Clock.h"
+#include "BaseException.h"
+#include "Bugcheck.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace
+{
+	const UInt32 RING_MAGIC     = 0x474e5253;	// "SRNG"
+	const UInt32 RING_VERSION   = 1;
+	const UInt64 MIN_CAPACITY   = 4096;
+	const int    SPIN_COUNT     = 100;
+	const long   RECOVER_PERIOD = 100;
+
+	// Record header word: body length in the low 32 bits, producer pid in
+	// bits 32-61, then the padding and committed flags. A zero word is a
+	// record that has been reserved but not stamped yet; if its producer
+	// dies right there, nothing tells the consumer who owned it or how long
+	// it is, so it cannot be recovered.
+	const UInt64 RECORD_HEADER  = sizeof(UInt64);
+	const UInt64 LENGTH_MASK    = 0xffffffffULL;
+	const UInt64 PID_MASK       = 0x3fffffffULL;
+	const UInt64 PADDING        = 1ULL << 62;
+	const UInt64 COMMITTED      = 1ULL << 63;
+
+	inline UInt64 recordSize(UInt64 length)
+	{
+		return RECORD_HEADER + ((length + 7) & ~UInt64(7));
+	}
+
+	inline std::atomic<UInt64>& recordWord(char* pData, UInt64 offset)
+	{
+		return *reinterpret_cast<std::atomic<UInt64>*>(pData + offset);
+	}
+
+	inline long remaining(Int64 deadline, long milliseconds)
+	{
+		if (milliseconds < 0) return -1;
+		Int64 left = deadline - Clock::monotonicNanoseconds() / 1000000;
+		return left > 0 ? static_cast<long>(left) : 0;
+	}
+
+	UInt64 roundCapacity(std::size_t capacity)
+	{
+		UInt64 size = MIN_CAPACITY;
+		while (size < capacity) size <<= 1;
+		return size;
+	}
+}
+
+
+struct SharedRing::Header
+{
+	std::atomic<UInt32> magic;		///< stored last by the creator
+	UInt32              version;
+	UInt64              capacity;
+	UInt32              mode;
+	Int32               creator;
+
+	alignas(64) std::atomic<UInt64> tail;
+	alignas(64) std::atomic<UInt64> head;
+	alignas(64) std::atomic<int>    consumerWaiting;
+	std::atomic<int>                dataSignal;
+	alignas(64) std::atomic<int>    producersWaiting;
+	std::atomic<int>                spaceSignal;
+};
+
+
+static_assert(std::atomic<UInt64>::is_always_lock_free, "shared ring needs address free 64-bit atomics");
+static_assert(sizeof(std::atomic<UInt64>) == sizeof(UInt64), "unexpected atomic layout");
+
+
+// A crashed creator leaves its segment behind; never reuse its header. A
+// ring whose creator is still running is live, and replacing it would
+// split its producers and consumers across two segments.
+const std::string& SharedRing::unlinkStale(const std::string& name)
+{
+	const std::string path = "/" + name;
+	int fd = ::shm_open(path.c_str(), O_RDONLY, 0);
+	if (fd == -1) return name;
+
+	bool live = false;
+	struct stat st;
+	if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(Header))
+	{
+		void* p = ::mmap(0, sizeof(Header), PROT_READ, MAP_SHARED, fd, 0);
+		if (p != MAP_FAILED)
+		{
+			const Header* pHeader = static_cast<const Header*>(p);
+			if (pHeader->magic.load(std::memory_order_acquire) == RING_MAGIC && pHeader->creator > 0)
+				live = ::kill(pHeader->creator, 0) == 0 || errno != ESRCH;
+			::munmap(p, sizeof(Header));
+		}
+	}
+	::close(fd);
+
+	if (live) throw FileExistsException("shared ring is in use", name);
+	::shm_unlink(path.c_str());
+	return name;
+}
+
+
+SharedRing::SharedRing(const std::string& name, std::size_t capacity, RingMode mode):
+	_name(name),
+	_memory(unlinkStale(name), sizeof(Header) + roundCapacity(capacity), SharedMemory::AM_WRITE),
+	_pHeader(nullptr),
+	_pData(nullptr),
+	_mask(0),
+	_mode(mode),
+	_pid(static_cast<UInt64>(::getpid()) & PID_MASK),
+	_producerHead(0),
+	_producerTail(0),
+	_consumerTail(0),
+	_peekSize(0)
+{
+	UInt64 size = _memory.size() - sizeof(Header);
+	_pHeader = reinterpret_cast<Header*>(_memory.begin());
+	_pData = _memory.begin() + sizeof(Header);
+	_mask = size - 1;
+
+	Header* pHeader = new (_pHeader) Header;
+	pHeader->version = RING_VERSION;
+	pHeader->capacity = size;
+	pHeader->mode = static_cast<UInt32>(mode);
+	pHeader->creator = static_cast<Int32>(::getpid());
+	pHeader->tail.store(0, std::memory_order_relaxed);
+	pHeader->head.store(0, std::memory_order_relaxed);
+	pHeader->consumerWaiting.store(0, std::memory_order_relaxed);
+	pHeader->dataSignal.store(0, std::memory_order_relaxed);
+	pHeader->producersWaiting.store(0, std::memory_order_relaxed);
+	pHeader->spaceSignal.store(0, std::memory_order_relaxed);
+	pHeader->magic.store(RING_MAGIC, std::memory_order_release);
+}
+
+
+SharedRing::SharedRing(const std::string& name):
+	_name(name),
+	_memory(name, 0, SharedMemory::AM_WRITE, 0, false),
+	_pHeader(nullptr),
+	_pData(nullptr),
+	_mask(0),
+	_mode(RING_SPSC),
+	_pid(static_cast<UInt64>(::getpid()) & PID_MASK),
+	_producerHead(0),
+	_producerTail(0),
+	_consumerTail(0),
+	_peekSize(0)
+{
+	attach();
+}
+
+
+SharedRing::~SharedRing()
+{
+}
+
+
+void SharedRing::attach()
+{
+	if (_memory.size() < sizeof(Header))
+		throw DataFormatException("shared ring segment too small", _name);
+
+	Header* pHeader = reinterpret_cast<Header*>(_memory.begin());
+	if (pHeader->magic.load(std::memory_order_acquire) != RING_MAGIC)
+		throw IllegalStateException("shared ring is not initialized", _name);
+	if (pHeader->version != RING_VERSION)
+		throw DataFormatException("shared ring version mismatch", _name);
+
+	UInt64 size = pHeader->capacity;
+	if (size < MIN_CAPACITY || (size & (size - 1)) != 0 || sizeof(Header) + size != _memory.size()
+		|| pHeader->mode > static_cast<UInt32>(RING_MPSC))
+		throw DataFormatException("corrupt shared ring header", _name);
+
+	_pHeader = pHeader;
+	_pData = _memory.begin() + sizeof(Header);
+	_mask = size - 1;
+	_mode = static_cast<RingMode>(pHeader->mode);
+	_producerHead = _pHeader->head.load(std::memory_order_acquire);
+	_producerTail = _pHeader->tail.load(std::memory_order_acquire);
+	_consumerTail = _producerTail;
+}
+
+
+std::size_t SharedRing::maxRecord() const
+{
+	// A record plus the padding that may precede it must fit an empty ring.
+	// The record header only has 32 bits for the length.
+	return static_cast<std::size_t>(std::min(capacity() / 2 - RECORD_HEADER, LENGTH_MASK));
+}
+
+
+char* SharedRing::tryReserve(std::size_t length)
+{
+	if (length > maxRecord())
+		throw InvalidArgumentException("record exceeds shared ring capacity", _name);
+
+	const UInt64 capacity = _mask + 1;
+	const UInt64 size = recordSize(length);
+	UInt64 tail = _mode == RING_SPSC ? _producerTail : _pHeader->tail.load(std::memory_order_relaxed);
+	UInt64 offset, pad;
+	for (;;)
+	{
+		offset = tail & _mask;
+		pad = offset + size > capacity ? capacity - offset : 0;
+
+		if (_mode == RING_SPSC)
+		{
+			if (tail + pad + size - _producerHead > capacity)
+			{
+				_producerHead = _pHeader->head.load(std::memory_order_acquire);
+				if (tail + pad + size - _producerHead > capacity) return nullptr;
+			}
+			_producerTail = tail + pad + size;
+			break;
+		}
+
+		// Acquiring head also orders the consumer's zeroing of the space.
+		if (tail + pad + size - _pHeader->head.load(std::memory_order_acquire) > capacity)
+			return nullptr;
+		if (_pHeader->tail.compare_exchange_weak(tail, tail + pad + size, std::memory_order_relaxed, std::memory_order_relaxed))
+			break;
+	}
+
+	UInt64 recordOffset = pad ? 0 : offset;
+	recordWord(_pData, recordOffset).store(UInt64(length) | (_pid << 32), std::memory_order_relaxed);
+	if (pad)
+		recordWord(_pData, offset).store((pad - RECORD_HEADER) | (_pid << 32) | PADDING | COMMITTED, std::memory_order_release);
+	return _pData + recordOffset + RECORD_HEADER;
+}
+
+
+char* SharedRing::reserve(std::size_t length, long milliseconds)
+{
+	for (int i = 0; i < SPIN_COUNT; ++i)
+	{
+		if (char* p = tryReserve(length)) return p;
+		Futex::pause();
+	}
+
+	Int64 deadline = Clock::monotonicNanoseconds() / 1000000 + milliseconds;
+	for (;;)
+	{
+		_pHeader->producersWaiting.fetch_add(1, std::memory_order_seq_cst);
+		int signal = _pHeader->spaceSignal.load(std::memory_order_seq_cst);
+		char* p = tryReserve(length);
+		long left = remaining(deadline, milliseconds);
+		if (!p && left != 0)
+			Futex::waitShared(_pHeader->spaceSignal, signal, left);
+		_pHeader->producersWaiting.fetch_sub(1, std::memory_order_relaxed);
+		if (p) return p;
+		if (left == 0) return tryReserve(length);
+	}
+}
+
+
+void SharedRing::commit(char* pRecord)
+{
+	std::atomic<UInt64>& word = *reinterpret_cast<std::atomic<UInt64>*>(pRecord - RECORD_HEADER);
+	UInt64 header = word.load(std::memory_order_relaxed);
+	if (_mode == RING_SPSC)
+	{
+		word.store(header | COMMITTED, std::memory_order_relaxed);
+		_pHeader->tail.store(_producerTail, std::memory_order_seq_cst);
+	}
+	else
+	{
+		word.store(header | COMMITTED, std::memory_order_seq_cst);
+	}
+	notifyConsumer();
+}
+
+
+void SharedRing::notifyConsumer()
+{
+	// Pairs with the waiting flag in peek(): either the consumer sees the
+	// record or we see the consumer waiting.
+	if (_pHeader->consumerWaiting.load(std::memory_order_seq_cst))
+	{
+		_pHeader->dataSignal.fetch_add(1, std::memory_order_seq_cst);
+		Futex::wakeShared(_pHeader->dataSignal, 1);
+	}
+}
+
+
+bool SharedRing::tryWrite(const void* pData, std::size_t length)
+{
+	char* p = tryReserve(length);
+	if (!p) return false;
+	std::memcpy(p, pData, length);
+	commit(p);
+	return true;
+}
+
+
+bool SharedRing::write(const void* pData, std::size_t length, long milliseconds)
+{
+	char* p = reserve(length, milliseconds);
+	if (!p) return false;
+	std::memcpy(p, pData, length);
+	commit(p);
+	return true;
+}
+
+
+const char* SharedRing::tryPeek(std::size_t& length)
+{
+	UInt64 head = _pHeader->head.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		if (_mode == RING_SPSC && head == _consumerTail)
+		{
+			_consumerTail = _pHeader->tail.load(std::memory_order_seq_cst);
+			if (head == _consumerTail) return nullptr;
+		}
+
+		// In MPSC mode unconsumed space is zero, so an uncommitted word
+		// is a record still being written.
+		UInt64 offset = head & _mask;
+		UInt64 word = recordWord(_pData, offset).load(std::memory_order_seq_cst);
+		if (!(word & COMMITTED)) return nullptr;
+
+		UInt64 size = recordSize(word & LENGTH_MASK);
+		if (word & PADDING)
+		{
+			consume(size);
+			head += size;
+			continue;
+		}
+
+		_peekSize = size;
+		length = static_cast<std::size_t>(word & LENGTH_MASK);
+		return _pData + offset + RECORD_HEADER;
+	}
+}
+
+
+const char* SharedRing::peek(std::size_t& length, long milliseconds)
+{
+	for (int i = 0; i < SPIN_COUNT; ++i)
+	{
+		if (const char* p = tryPeek(length)) return p;
+		Futex::pause();
+	}
+
+	Int64 deadline = Clock::monotonicNanoseconds() / 1000000 + milliseconds;
+	for (;;)
+	{
+		_pHeader->consumerWaiting.store(1, std::memory_order_seq_cst);
+		int signal = _pHeader->dataSignal.load(std::memory_order_seq_cst);
+		const char* p = tryPeek(length);
+		long left = remaining(deadline, milliseconds);
+		bool woken = true;
+		if (!p && left != 0)
+			woken = Futex::waitShared(_pHeader->dataSignal, signal, left < 0 || left > RECOVER_PERIOD ? RECOVER_PERIOD : left);
+		_pHeader->consumerWaiting.store(0, std::memory_order_relaxed);
+		if (p) return p;
+		if (left == 0) return tryPeek(length);
+		if (!woken) recover();
+	}
+}
+
+
+void SharedRing::release()
+{
+	ASSERT_DBG(_peekSize != 0);
+	consume(_peekSize);
+	_peekSize = 0;
+}
+
+
+void SharedRing::consume(UInt64 size)
+{
+	UInt64 head = _pHeader->head.load(std::memory_order_relaxed);
+	if (_mode == RING_MPSC)
+		std::memset(_pData + (head & _mask), 0, size);
+	_pHeader->head.store(head + size, std::memory_order_seq_cst);
+
+	if (_pHeader->producersWaiting.load(std::memory_order_seq_cst) > 0)
+	{
+		_pHeader->spaceSignal.fetch_add(1, std::memory_order_seq_cst);
+		Futex::wakeShared(_pHeader->spaceSignal, INT_MAX);
+	}
+}
+
+
+bool SharedRing::recover()
+{
+	// An SPSC producer publishes tail only after the record is complete.
+	if (_mode == RING_SPSC) return false;
+
+	UInt64 head = _pHeader->head.load(std::memory_order_relaxed);
+	UInt64 word = recordWord(_pData, head & _mask).load(std::memory_order_acquire);
+	// A zero word has no pid to check and no length to skip.
+	if (word == 0 || (word & COMMITTED)) return false;
+
+	pid_t pid = static_cast<pid_t>((word >> 32) & PID_MASK);
+	if (::kill(pid, 0) == 0 || errno != ESRCH) return false;
+
+	consume(recordSize(word & LENGTH_MASK));
+	return true;
+}
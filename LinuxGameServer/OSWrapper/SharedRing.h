@@ -0,0 +1,134 @@
+#pragma once
+
+#include "SharedMemory.h"
+#include "Types.h"
+#include <cstddef>
+#include <string>
+
+
+// Message ring in a named SharedMemory segment, for processes on the same
+// host (gateway, zone and DB proxy) that would otherwise talk over loopback
+// TCP.
+//
+// Records are variable length and written in place: tryReserve() returns
+// room for one record inside the ring, commit() publishes it, and the
+// consumer reads it in place through tryPeek() until release(). write()
+// and peek() wrap the same calls with a copy or a blocking wait.
+//
+// RING_SPSC allows one producer; RING_MPSC lets any number of producers,
+// in any number of processes, reserve concurrently. Both allow exactly one
+// consumer. Producer and consumer positions live on separate cache lines.
+// Sleeping sides park on process shared futex words in the segment and are
+// woken only when the other side sees them waiting.
+//
+// The header is published last, so attaching to a half-initialized segment
+// fails instead of reading garbage. Every record is stamped with its
+// producer's pid right after its space is claimed; if that process dies
+// between stamping and committing, recover() (also run by a blocking
+// peek() that finds nothing) skips the record instead of stalling the ring
+// forever. A producer killed in the few instructions between claiming the
+// space and stamping it leaves an unattributed record that cannot be
+// skipped; the ring then stalls and has to be recreated.
+class SharedRing
+{
+public:
+	enum RingMode
+	{
+		RING_SPSC,
+		RING_MPSC
+	};
+
+	// Creates the ring, replacing a stale segment of the same name: one
+	// that was never initialized or whose creator has exited. Throws a
+	// FileExistsException if the creator of the existing ring is alive.
+	// capacity is rounded up to a power of two of at least one page.
+	SharedRing(const std::string& name, std::size_t capacity, RingMode mode);
+
+	// Attaches to a ring created by another process.
+	explicit SharedRing(const std::string& name);
+
+	~SharedRing();
+
+	// Returns room for length bytes, or null if the ring is full.
+	char* tryReserve(std::size_t length);
+
+	// Waits for room; returns null on timeout. A negative timeout waits
+	// forever.
+	char* reserve(std::size_t length, long milliseconds = -1);
+
+	// Publishes a record returned by tryReserve() or reserve().
+	void commit(char* pRecord);
+
+	bool tryWrite(const void* pData, std::size_t length);
+
+	bool write(const void* pData, std::size_t length, long milliseconds = -1);
+
+	// Returns the oldest record and its length, or null if there is none.
+	// The record stays valid until release().
+	const char* tryPeek(std::size_t& length);
+
+	// Waits for a record; returns null on timeout.
+	const char* peek(std::size_t& length, long milliseconds = -1);
+
+	// Drops the record returned by the last peek.
+	void release();
+
+	// Skips a record whose producer died after stamping it but before
+	// committing it. Returns true if one was skipped.
+	bool recover();
+
+	std::size_t capacity() const;
+
+	// Largest record length tryReserve() accepts.
+	std::size_t maxRecord() const;
+
+	RingMode mode() const;
+
+	const std::string& name() const;
+
+private:
+	SharedRing();
+	SharedRing(const SharedRing&);
+	SharedRing& operator = (const SharedRing&);
+
+	struct Header;
+
+	static const std::string& unlinkStale(const std::string& name);
+
+	void attach();
+	void consume(UInt64 size);
+	void notifyConsumer();
+
+	std::string  _name;
+	SharedMemory _memory;
+	Header*      _pHeader;
+	char*        _pData;
+	UInt64       _mask;
+	RingMode     _mode;
+	UInt64       _pid;
+	UInt64       _producerHead;		///< SPSC producer's last seen consumer position
+	UInt64       _producerTail;		///< SPSC tail to publish on commit()
+	UInt64       _consumerTail;		///< SPSC consumer's last seen producer position
+	UInt64       _peekSize;
+};
+
+
+//
+// inlines
+//
+inline std::size_t SharedRing::capacity() const
+{
+	return static_cast<std::size_t>(_mask + 1);
+}
+
+
+inline SharedRing::RingMode SharedRing::mode() const
+{
+	return _mode;
+}
+
+
+inline const std::string& SharedRing::name() const
+{
+	return _name;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Futex.h"
+#include <atomic>
+#include <mutex>
+#include <sched.h>
+
+
+// Test-and-test-and-set lock for critical sections of a few instructions.
+// It never sleeps, so a holder that blocks stalls every contender; after a
+// while of spinning contenders yield the CPU.
+class SpinMutex
+{
+public:
+	typedef std::lock_guard<SpinMutex> ScopedLock;
+
+	SpinMutex();
+
+	void lock();
+
+	bool tryLock();
+
+	void unlock();
+
+private:
+	SpinMutex(const SpinMutex&);
+	SpinMutex& operator = (const SpinMutex&);
+
+	std::atomic<bool> _locked;
+};
+
+
+//
+// inlines
+//
+inline SpinMutex::SpinMutex():
+	_locked(false)
+{
+}
+
+
+inline bool SpinMutex::tryLock()
+{
+	return !_locked.load(std::memory_order_relaxed) && !_locked.exchange(true, std::memory_order_acquire);
+}
+
+
+inline void SpinMutex::lock()
+{
+	for (int spin = 0; !tryLock(); ++spin)
+	{
+		while (_locked.load(std::memory_order_relaxed))
+		{
+			if (++spin < 1000)
+				Futex::pause();
+			else
+				::sched_yield();
+		}
+	}
+}
+
+
+inline void SpinMutex::unlock()
+{
+	_locked.store(false, std::memory_order_release);
+}
@@ -2,13 +2,77 @@
 #include "BaseException.h"
 #include "ThreadLocal.h"
 #include "Timespan.h"
-#include "Timestamp.h"
+#include "Clock.h"
 #include "Runnable.h"
 #include "ErrorHandler.h"
 #include <sstream>
+#include <fstream>
+#include <map>
 #include <signal.h>
 #include <time.h>
 #include <atomic>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+namespace
+{
+	struct Placement
+	{
+		std::vector<int> cpus;
+		int              node;
+	};
+
+	typedef std::map<std::string, Placement> PlacementMap;
+
+	std::mutex& placementMutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	PlacementMap& placementMap()
+	{
+		static PlacementMap map;
+		return map;
+	}
+
+	bool findPlacement(const std::string& name, Placement& placement)
+	{
+		std::lock_guard<std::mutex> lock(placementMutex());
+		const PlacementMap& map = placementMap();
+		PlacementMap::const_iterator best = map.end();
+		for (PlacementMap::const_iterator it = map.begin(); it != map.end(); ++it)
+		{
+			if (name.compare(0, it->first.size(), it->first) == 0 && (best == map.end() || it->first.size() > best->first.size()))
+				best = it;
+		}
+		if (best == map.end()) return false;
+		placement = best->second;
+		return true;
+	}
+
+	void makeCpuSet(const std::vector<int>& cpus, cpu_set_t& set)
+	{
+		CPU_ZERO(&set);
+		for (std::size_t i = 0; i < cpus.size(); ++i)
+		{
+			if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE)
+				throw InvalidArgumentException("invalid CPU number", std::to_string(cpus[i]));
+			CPU_SET(cpus[i], &set);
+		}
+	}
+
+	bool setPreferredNode(int node)
+	{
+		unsigned long mask[16] = {0};
+		if (node < 0 || node >= int(sizeof(mask) * 8)) return false;
+		mask[node / (sizeof(unsigned long) * 8)] |= 1UL << (node % (sizeof(unsigned long) * 8));
+		return ::syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, sizeof(mask) * 8) == 0;
+	}
+}
+
 
 class RunnableHolder : public Runnable
 {
@@ -61,8 +125,8 @@ Thread::CurrentThreadHolder Thread::_currentThreadHolder;
 Thread::Thread() :
 	_id(uniqueId()),
 	_name(makeName()),
-	_pTLS(0),
-	_event(Event::EVENT_AUTORESET)
+	_event(Event::EVENT_AUTORESET),
+	_pData(new ThreadData)
 {
 }
 
@@ -70,15 +134,16 @@ Thread::Thread() :
 Thread::Thread(const std::string& name) :
 	_id(uniqueId()),
 	_name(name),
-	_pTLS(0),
-	_event(Event::EVENT_AUTORESET)
+	_event(Event::EVENT_AUTORESET),
+	_pData(new ThreadData)
 {
 }
 
 
 Thread::~Thread()
 {
-	delete _pTLS;
+	if (_pData->started && !_pData->joined)
+		::pthread_detach(_pData->thread);
 }
 
 
@@ -116,6 +181,12 @@ void Thread::start(RunnablePtr pTarget)
 	if (_pData->pRunnableTarget)
 		throw SystemException("thread already running");
 
+	// Everything that can throw runs before the attributes exist.
+	applyPlacement();
+	cpu_set_t set;
+	if (!_pData->affinity.empty())
+		makeCpuSet(_pData->affinity, set);
+
 	pthread_attr_t attributes;
 	pthread_attr_init(&attributes);
 
@@ -128,6 +199,15 @@ void Thread::start(RunnablePtr pTarget)
 		}
 	}
 
+	if (!_pData->affinity.empty())
+	{
+		if (0 != pthread_attr_setaffinity_np(&attributes, sizeof(set), &set))
+		{
+			pthread_attr_destroy(&attributes);
+			throw SystemException("cannot set thread affinity");
+		}
+	}
+
 	_pData->pRunnableTarget = pTarget;
 	if (pthread_create(&_pData->thread, &attributes, runnableEntry, this))
 	{
@@ -164,6 +244,12 @@ void Thread::start(Callable target, void* pData)
 }
 
 
+void Thread::startImpl(Runnable* pTarget)
+{
+	start(RunnablePtr(pTarget));
+}
+
+
 void Thread::join()
 {
 	if (!_pData->started) return;
@@ -215,19 +301,13 @@ void Thread::wakeUp()
 
 ThreadLocalStorage& Thread::tls()
 {
-	if (!_pTLS)
-		_pTLS = new ThreadLocalStorage;
-	return *_pTLS;
+	return ThreadLocalStorage::current();
 }
 
 
 void Thread::clearTLS()
 {
-	if (_pTLS)
-	{
-		delete _pTLS;
-		_pTLS = 0;
-	}
+	ThreadLocalStorage::clear();
 }
 
 
@@ -254,6 +334,139 @@ void Thread::setName(const std::string& name)
 }
 
 
+// Only called by start(), before the thread exists; runnableEntry() then
+// applies the memory policy from the new thread itself.
+void Thread::applyPlacement()
+{
+	if (_pData->placed) return;
+
+	Placement placement;
+	if (!findPlacement(name(), placement)) return;
+
+	_pData->affinity = placement.cpus;
+	_pData->numaNode = placement.node;
+}
+
+
+void Thread::setAffinity(int cpu)
+{
+	setAffinity(std::vector<int>(1, cpu));
+}
+
+
+void Thread::setAffinity(const std::vector<int>& cpus)
+{
+	cpu_set_t set;
+	makeCpuSet(cpus, set);
+	if (isRunning())
+	{
+		if (pthread_setaffinity_np(_pData->thread, sizeof(set), &set))
+			throw SystemException("cannot set thread affinity");
+	}
+	_pData->affinity = cpus;
+	_pData->placed = true;
+}
+
+
+std::vector<int> Thread::getAffinity() const
+{
+	if (!isRunning()) return _pData->affinity;
+
+	cpu_set_t set;
+	if (pthread_getaffinity_np(_pData->thread, sizeof(set), &set))
+		throw SystemException("cannot get thread affinity");
+	std::vector<int> cpus;
+	for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+	{
+		if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+	}
+	return cpus;
+}
+
+
+void Thread::setNumaNode(int node)
+{
+	std::vector<int> cpus = numaNodeCpus(node);
+	if (cpus.empty())
+		throw InvalidArgumentException("invalid NUMA node", std::to_string(node));
+
+	setAffinity(cpus);
+	_pData->numaNode = node;
+	if (current() == this && !setPreferredNode(node))
+		throw SystemException("cannot set NUMA memory policy");
+}
+
+
+int Thread::getNumaNode() const
+{
+	return _pData->numaNode;
+}
+
+
+void Thread::setPlacement(const std::string& name, const std::vector<int>& cpus, int node)
+{
+	Placement placement;
+	if (!cpus.empty() || node >= 0)
+	{
+		placement.cpus = cpus.empty() ? numaNodeCpus(node) : cpus;
+		placement.node = node;
+		cpu_set_t set;
+		makeCpuSet(placement.cpus, set);
+	}
+
+	std::lock_guard<std::mutex> lock(placementMutex());
+	if (cpus.empty() && node < 0)
+		placementMap().erase(name);
+	else
+		placementMap()[name] = placement;
+}
+
+
+std::vector<int> Thread::parseCpuList(const std::string& list)
+{
+	std::vector<int> cpus;
+	std::string::size_type pos = 0;
+	while (pos < list.size())
+	{
+		std::string::size_type end = list.find(',', pos);
+		if (end == std::string::npos) end = list.size();
+		std::string item = list.substr(pos, end - pos);
+		pos = end + 1;
+
+		item.erase(0, item.find_first_not_of(" \t\n"));
+		item.erase(item.find_last_not_of(" \t\n") + 1);
+		if (item.empty()) continue;
+
+		std::string::size_type dash = item.find('-');
+		try
+		{
+			int first = std::stoi(item.substr(0, dash));
+			int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+			if (first < 0 || last < first)
+				throw InvalidArgumentException("invalid CPU list", list);
+			for (int cpu = first; cpu <= last; ++cpu)
+				cpus.push_back(cpu);
+		}
+		catch (std::logic_error&)
+		{
+			throw InvalidArgumentException("invalid CPU list", list);
+		}
+	}
+	return cpus;
+}
+
+
+std::vector<int> Thread::numaNodeCpus(int node)
+{
+	if (node < 0) return std::vector<int>();
+
+	std::ifstream istr("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+	std::string list;
+	if (!std::getline(istr, list)) return std::vector<int>();
+	return parseCpuList(list);
+}
+
+
 Thread::TID Thread::tid() const
 {
 	return _pData->thread;
@@ -297,11 +510,10 @@ void Thread::sleep(long milliseconds)
 		struct timespec ts;
 		ts.tv_sec = (long)remainingTime.totalSeconds();
 		ts.tv_nsec = (long)remainingTime.useconds() * 1000;
-		Timestamp start;
+		Clock start;
 		rc = ::nanosleep(&ts, 0);
 		if (rc < 0 && errno == EINTR)
 		{
-			Timestamp end;
 			Timespan waited = start.elapsed();
 			if (waited < remainingTime)
 				remainingTime -= waited;
@@ -411,10 +623,12 @@ void Thread::setStackSize(int size)
 	 //pthread_sigmask(SIG_BLOCK, &sset, 0);
 
 	 Thread* pThread = reinterpret_cast<Thread*>(pvThread);
+	 if (pThread->_pData->numaNode >= 0)
+		 setPreferredNode(pThread->_pData->numaNode);
 #if defined(_DEBUG)
-	 setThreadName(pThread->_pData->thread, reinterpret_cast<Thread*>(pThread)->getName());
+	 ::pthread_setname_np(pThread->_pData->thread, pThread->getName().substr(0, 15).c_str());
 #endif
-	 std::auto_ptr<ThreadData> pData = pThread->_pData;
+	 AutoPtr<ThreadData> pData = pThread->_pData;
 	 try
 	 {
 		 pData->pRunnableTarget->run();
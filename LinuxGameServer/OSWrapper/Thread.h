@@ -3,6 +3,7 @@
 
 #include "RefCountedObject.h"
 #include "SharedPtr.h"
+#include "AutoPtr.h"
 #include "Event.h"
 #include "Runnable.h"
 
@@ -11,6 +12,8 @@
 #include <errno.h>
 #include <mutex>
 #include <memory>
+#include <string>
+#include <vector>
 #include <pthread.h>
 
 #ifndef _THREAD_STACK_SIZE
@@ -77,6 +80,35 @@ public:
 
 	int getStackSize() const;
 
+	// Restricts the thread to the given CPUs. Takes effect immediately if
+	// the thread is running, otherwise when it starts.
+	void setAffinity(int cpu);
+
+	void setAffinity(const std::vector<int>& cpus);
+
+	std::vector<int> getAffinity() const;
+
+	// Binds the thread to the CPUs of a NUMA node and makes that node the
+	// preferred one for its allocations, including its stack. The memory
+	// policy can only be changed by the thread itself, so for a running
+	// thread it is applied only when called from that thread.
+	void setNumaNode(int node);
+
+	int getNumaNode() const;
+
+	// Registers the placement of threads by name. A thread without an
+	// explicit affinity picks up the placement whose name is the longest
+	// prefix of its own name when it starts, so "zone" also covers "zone1"
+	// and "zone[#3]"; renaming a running thread does not move it. An empty
+	// cpu list with node -1 removes the entry. Throws an
+	// InvalidArgumentException for CPU numbers out of range.
+	static void setPlacement(const std::string& name, const std::vector<int>& cpus, int node = -1);
+
+	// Parses a list in the kernel's cpulist format, e.g. "0-3,8,10-11".
+	static std::vector<int> parseCpuList(const std::string& list);
+
+	static std::vector<int> numaNodeCpus(int node);
+
 	void start(Runnable& target);
 
 	void start(RunnablePtr pTarget);
@@ -124,6 +156,10 @@ protected:
 
 	static int uniqueId();
 
+	void startImpl(Runnable* pTarget);
+
+	void applyPlacement();
+
 	template <class Functor>
 	class FunctorRunnable : public Runnable
 	{
@@ -157,12 +193,12 @@ private:
 
 	int                 _id;
 	std::string         _name;
-	ThreadLocalStorage* _pTLS;
 	Event               _event;
 	mutable std::mutex   _mutex;
 
 	friend class ThreadLocalStorage;
 	friend class PooledThread;
+	friend class ThreadPool;
 
 
 
@@ -207,6 +243,8 @@ private:
 			policy(SCHED_OTHER),
 			done(Event::EVENT_MANUALRESET),
 			stackSize(_THREAD_STACK_SIZE),
+			numaNode(-1),
+			placed(false),
 			started(false),
 			joined(false)
 		{
@@ -219,11 +257,14 @@ private:
 		int           policy;
 		Event         done;
 		std::size_t   stackSize;
+		std::vector<int> affinity;
+		int           numaNode;
+		bool          placed;
 		bool          started;
 		bool          joined;
 	};
 
-	std::auto_ptr<ThreadData> _pData;
+	AutoPtr<ThreadData> _pData;
 
 	static CurrentThreadHolder _currentThreadHolder;
 };
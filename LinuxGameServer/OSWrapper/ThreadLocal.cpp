@@ -1,6 +1,5 @@
 #include "ThreadLocal.h"
-#include "SingletonHolder.h"
-#include "Thread.h"
+#include <mutex>
 
 TLSAbstractSlot::TLSAbstractSlot()
 {
@@ -19,46 +18,94 @@ ThreadLocalStorage::ThreadLocalStorage()
 
 ThreadLocalStorage::~ThreadLocalStorage()
 {
-	for (auto& p : _map)
+	for (auto& entry : _slots)
 	{
-		delete p.second;
+		delete entry.pSlot;
 	}
 }
 
 
-TLSAbstractSlot*& ThreadLocalStorage::get(const void* key)
+TLSAbstractSlot*& ThreadLocalStorage::getSlow(std::size_t index, UInt64 id)
 {
-	TLSMap::iterator it = _map.find(key);
-	if (it == _map.end())
-		return _map.insert(TLSMap::value_type(key, reinterpret_cast<TLSAbstractSlot*>(0))).first->second;
-	else
-		return it->second;
+	if (index >= _slots.size())
+	{
+		Entry empty = { nullptr, 0 };
+		_slots.resize(index + 1, empty);
+	}
+	Entry& entry = _slots[index];
+	if (entry.id != id)
+	{
+		// left behind by a destroyed ThreadLocal that had the same index
+		delete entry.pSlot;
+		entry.pSlot = nullptr;
+		entry.id = id;
+	}
+	return entry.pSlot;
 }
 
 
 namespace
 {
-	static SingletonHolder<ThreadLocalStorage> sh;
-}
-
+	struct StorageCleanup
+	{
+		~StorageCleanup()
+		{
+			ThreadLocalStorage::clear();
+		}
+	};
 
-ThreadLocalStorage& ThreadLocalStorage::current()
-{
-	Thread* pThread = Thread::current();
-	if (pThread)
+	struct IndexRegistry
 	{
-		return pThread->tls();
-	}
-	else
+		std::mutex               mutex;
+		std::vector<std::size_t> freeIndices;
+		std::size_t              nextIndex = 0;
+		UInt64                   nextId = 0;
+	};
+
+	// Leaked on purpose: static ThreadLocal objects in other translation
+	// units may release their index after this one's statics are destroyed.
+	IndexRegistry& registry()
 	{
-		return *sh.get();
+		static IndexRegistry* pRegistry = new IndexRegistry;
+		return *pRegistry;
 	}
 }
 
 
+ThreadLocalStorage& ThreadLocalStorage::create()
+{
+	// Registers the per-thread destructor that frees the storage at exit.
+	static thread_local StorageCleanup cleanup;
+	(void) cleanup;
+
+	_pCurrent = new ThreadLocalStorage;
+	return *_pCurrent;
+}
+
+
 void ThreadLocalStorage::clear()
 {
-	Thread* pThread = Thread::current();
-	if (pThread)
-		pThread->clearTLS();
+	delete _pCurrent;
+	_pCurrent = nullptr;
+}
+
+
+std::size_t ThreadLocalStorage::acquireIndex(UInt64& id)
+{
+	IndexRegistry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	id = ++reg.nextId;
+	if (reg.freeIndices.empty())
+		return reg.nextIndex++;
+	std::size_t index = reg.freeIndices.back();
+	reg.freeIndices.pop_back();
+	return index;
+}
+
+
+void ThreadLocalStorage::releaseIndex(std::size_t index)
+{
+	IndexRegistry& reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	reg.freeIndices.push_back(index);
 }
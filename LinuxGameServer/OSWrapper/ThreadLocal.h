@@ -1,6 +1,8 @@
 #pragma once
 
-#include <map>
+#include "Types.h"
+#include <cstddef>
+#include <vector>
 
 class TLSAbstractSlot
 {
@@ -36,6 +38,11 @@ private:
 };
 
 
+// Per-thread array of slots, one per ThreadLocal index. Every thread,
+// whether started through Thread or not, reaches its own storage through a
+// native thread_local pointer, so a lookup is that load plus an indexed
+// load. Indices are recycled; the id stored with each slot tells a live
+// ThreadLocal from a destroyed one that had the same index.
 class ThreadLocalStorage
 {
 public:
@@ -43,16 +50,30 @@ public:
 
 	~ThreadLocalStorage();
 
-	TLSAbstractSlot*& get(const void* key);
+	TLSAbstractSlot*& get(std::size_t index, UInt64 id);
 
 	static ThreadLocalStorage& current();
 
 	static void clear();
 
+	static std::size_t acquireIndex(UInt64& id);
+
+	static void releaseIndex(std::size_t index);
+
 private:
-	typedef std::map<const void*, TLSAbstractSlot*> TLSMap;
+	struct Entry
+	{
+		TLSAbstractSlot* pSlot;
+		UInt64           id;
+	};
+
+	TLSAbstractSlot*& getSlow(std::size_t index, UInt64 id);
 
-	TLSMap _map;
+	static ThreadLocalStorage& create();
+
+	std::vector<Entry> _slots;
+
+	static inline thread_local ThreadLocalStorage* _pCurrent = nullptr;
 
 	friend class Thread;
 };
@@ -66,10 +87,12 @@ class ThreadLocal
 public:
 	ThreadLocal()
 	{
+		_index = ThreadLocalStorage::acquireIndex(_id);
 	}
 
 	~ThreadLocal()
 	{
+		ThreadLocalStorage::releaseIndex(_index);
 	}
 
 	C* operator -> ()
@@ -84,7 +107,7 @@ public:
 
 	C& get()
 	{
-		TLSAbstractSlot*& p = ThreadLocalStorage::current().get(this);
+		TLSAbstractSlot*& p = ThreadLocalStorage::current().get(_index, _id);
 		if (!p) p = new Slot;
 		return static_cast<Slot*>(p)->value();
 	}
@@ -92,4 +115,25 @@ public:
 private:
 	ThreadLocal(const ThreadLocal&);
 	ThreadLocal& operator = (const ThreadLocal&);
+
+	UInt64      _id;
+	std::size_t _index;
 };
+
+
+//
+// inlines
+//
+inline ThreadLocalStorage& ThreadLocalStorage::current()
+{
+	ThreadLocalStorage* pStorage = _pCurrent;
+	return pStorage ? *pStorage : create();
+}
+
+
+inline TLSAbstractSlot*& ThreadLocalStorage::get(std::size_t index, UInt64 id)
+{
+	if (index < _slots.size() && _slots[index].id == id)
+		return _slots[index].pSlot;
+	return getSlow(index, id);
+}
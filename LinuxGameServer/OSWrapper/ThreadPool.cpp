@@ -0,0 +1,419 @@
+#include "ThreadPool.h"
+#include "Futex.h"
+#include "BaseException.h"
+#include "Bugcheck.h"
+#include "ErrorHandler.h"
+#include "SingletonHolder.h"
+#include "Types.h"
+#include <climits>
+#include <sched.h>
+#include <unistd.h>
+
+
+namespace
+{
+	class TaskHolder: public Runnable
+	{
+	public:
+		TaskHolder(Runnable& target):
+			_target(target)
+		{
+		}
+
+		void run()
+		{
+			_target.run();
+		}
+
+	private:
+		Runnable& _target;
+	};
+
+
+	class SharedTaskHolder: public Runnable
+	{
+	public:
+		SharedTaskHolder(const RunnablePtr& pTarget):
+			_pTarget(pTarget)
+		{
+		}
+
+		void run()
+		{
+			_pTarget->run();
+		}
+
+	private:
+		RunnablePtr _pTarget;
+	};
+
+
+	// Chase-Lev deque as described by Le, Pop, Cohen and Zappa Nardelli,
+	// "Correct and Efficient Work-Stealing for Weak Memory Models". The owner
+	// pushes and pops at the bottom, thieves steal from the top. Arrays
+	// outgrown by push() are kept until destruction since a thief may still
+	// be reading from them.
+	class WorkStealingDeque
+	{
+	public:
+		WorkStealingDeque():
+			_top(0),
+			_bottom(0),
+			_pArray(new Array(64))
+		{
+		}
+
+		~WorkStealingDeque()
+		{
+			delete _pArray.load(std::memory_order_relaxed);
+			for (std::size_t i = 0; i < _retired.size(); ++i)
+				delete _retired[i];
+		}
+
+		void push(Runnable* pTask)
+		{
+			Int64 b = _bottom.load(std::memory_order_relaxed);
+			Int64 t = _top.load(std::memory_order_acquire);
+			Array* pArray = _pArray.load(std::memory_order_relaxed);
+			if (b - t > pArray->mask)
+				pArray = grow(pArray, t, b);
+			pArray->put(b, pTask);
+			_bottom.store(b + 1, std::memory_order_release);
+		}
+
+		Runnable* pop()
+		{
+			Int64 b = _bottom.load(std::memory_order_relaxed) - 1;
+			Array* pArray = _pArray.load(std::memory_order_relaxed);
+			_bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			Int64 t = _top.load(std::memory_order_relaxed);
+
+			Runnable* pTask = nullptr;
+			if (t <= b)
+			{
+				pTask = pArray->get(b);
+				if (t == b)
+				{
+					if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+						pTask = nullptr;
+					_bottom.store(b + 1, std::memory_order_relaxed);
+				}
+			}
+			else
+			{
+				_bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return pTask;
+		}
+
+		Runnable* steal()
+		{
+			Int64 t = _top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			Int64 b = _bottom.load(std::memory_order_acquire);
+			if (t < b)
+			{
+				Array* pArray = _pArray.load(std::memory_order_acquire);
+				Runnable* pTask = pArray->get(t);
+				if (_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					return pTask;
+			}
+			return nullptr;
+		}
+
+	private:
+		struct Array
+		{
+			explicit Array(Int64 capacity):
+				mask(capacity - 1),
+				slots(new std::atomic<Runnable*>[capacity])
+			{
+			}
+
+			~Array()
+			{
+				delete [] slots;
+			}
+
+			Runnable* get(Int64 i) const
+			{
+				return slots[i & mask].load(std::memory_order_relaxed);
+			}
+
+			void put(Int64 i, Runnable* pTask)
+			{
+				slots[i & mask].store(pTask, std::memory_order_relaxed);
+			}
+
+			Int64                   mask;
+			std::atomic<Runnable*>* slots;
+		};
+
+		Array* grow(Array* pArray, Int64 t, Int64 b)
+		{
+			Array* pNew = new Array(2 * (pArray->mask + 1));
+			for (Int64 i = t; i < b; ++i)
+				pNew->put(i, pArray->get(i));
+			_retired.push_back(pArray);
+			_pArray.store(pNew, std::memory_order_release);
+			return pNew;
+		}
+
+		alignas(64) std::atomic<Int64>  _top;
+		alignas(64) std::atomic<Int64>  _bottom;
+		std::atomic<Array*>             _pArray;
+		std::vector<Array*>             _retired;
+	};
+}
+
+
+class PooledThread: public Runnable
+{
+public:
+	PooledThread(ThreadPool& pool, int index, const std::string& name):
+		_pool(pool),
+		_index(index),
+		_thread(name)
+	{
+	}
+
+	void start()
+	{
+		_thread.start(*this);
+	}
+
+	void join()
+	{
+		_thread.join();
+	}
+
+	void run()
+	{
+		_pCurrent = this;
+		for (;;)
+		{
+			Runnable* pTask = _pool.findTask(this);
+			if (pTask)
+				_pool.runTask(pTask);
+			else if (!_pool.park())
+				break;
+		}
+		_pCurrent = nullptr;
+	}
+
+	static PooledThread* current()
+	{
+		return _pCurrent;
+	}
+
+	ThreadPool&       _pool;
+	int               _index;
+	Thread            _thread;
+	WorkStealingDeque _deques[ThreadPool::TASK_PRIO_COUNT];
+
+	static thread_local PooledThread* _pCurrent;
+};
+
+
+thread_local PooledThread* PooledThread::_pCurrent = nullptr;
+
+
+ThreadPool::ThreadPool(int threads, const std::string& name):
+	_name(name),
+	_queued(0),
+	_pending(0),
+	_sleepers(0),
+	_joiners(0),
+	_epoch(0),
+	_stopped(false)
+{
+	for (int i = 0; i < TASK_PRIO_COUNT; ++i)
+		_injectedCount[i].store(0, std::memory_order_relaxed);
+
+	if (threads <= 0) threads = cpuCount();
+	_threads.reserve(threads);
+	for (int i = 0; i < threads; ++i)
+		_threads.push_back(new PooledThread(*this, i, _name + "[#" + std::to_string(i) + "]"));
+	for (std::size_t i = 0; i < _threads.size(); ++i)
+		_threads[i]->start();
+}
+
+
+ThreadPool::~ThreadPool()
+{
+	try
+	{
+		joinAll();
+		_stopped.store(true, std::memory_order_seq_cst);
+		wake(INT_MAX);
+		// Other workers may still steal from a joined worker's deques.
+		for (std::size_t i = 0; i < _threads.size(); ++i)
+			_threads[i]->join();
+		for (std::size_t i = 0; i < _threads.size(); ++i)
+			delete _threads[i];
+	}
+	catch (...)
+	{
+		ASSERT_DBG(false);
+	}
+}
+
+
+void ThreadPool::start(Runnable& target, TaskPriority prio)
+{
+	schedule(new TaskHolder(target), prio);
+}
+
+
+void ThreadPool::start(RunnablePtr pTarget, TaskPriority prio)
+{
+	schedule(new SharedTaskHolder(pTarget), prio);
+}
+
+
+void ThreadPool::schedule(Runnable* pTask, TaskPriority prio)
+{
+	ASSERT(prio >= TASK_PRIO_LOW && prio < TASK_PRIO_COUNT);
+	if (_stopped.load(std::memory_order_relaxed))
+	{
+		delete pTask;
+		throw IllegalStateException("thread pool is stopped", _name);
+	}
+
+	_pending.fetch_add(1, std::memory_order_relaxed);
+
+	PooledThread* pSelf = PooledThread::current();
+	if (pSelf && &pSelf->_pool == this)
+	{
+		pSelf->_deques[prio].push(pTask);
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_injected[prio].push_back(pTask);
+		_injectedCount[prio].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Pairs with the sleeper count in park(): either we see the sleeper or
+	// it sees the queued task.
+	_queued.fetch_add(1, std::memory_order_seq_cst);
+	if (_sleepers.load(std::memory_order_seq_cst) > 0)
+		wake(1);
+}
+
+
+Runnable* ThreadPool::findTask(PooledThread* pSelf)
+{
+	const int count = static_cast<int>(_threads.size());
+	for (int prio = TASK_PRIO_COUNT - 1; prio >= 0; --prio)
+	{
+		Runnable* pTask = pSelf->_deques[prio].pop();
+
+		if (!pTask && _injectedCount[prio].load(std::memory_order_relaxed) > 0)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_injected[prio].empty())
+			{
+				pTask = _injected[prio].front();
+				_injected[prio].pop_front();
+				_injectedCount[prio].fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+
+		for (int i = 1; !pTask && i < count; ++i)
+			pTask = _threads[(pSelf->_index + i) % count]->_deques[prio].steal();
+
+		if (pTask)
+		{
+			_queued.fetch_sub(1, std::memory_order_relaxed);
+			return pTask;
+		}
+	}
+	return nullptr;
+}
+
+
+void ThreadPool::runTask(Runnable* pTask)
+{
+	try
+	{
+		pTask->run();
+	}
+	catch (Exception& exc)
+	{
+		ErrorHandler::handle(exc);
+	}
+	catch (std::exception& exc)
+	{
+		ErrorHandler::handle(exc);
+	}
+	catch (...)
+	{
+		ErrorHandler::handle();
+	}
+	delete pTask;
+
+	if (_pending.fetch_sub(1, std::memory_order_seq_cst) == 1 && _joiners.load(std::memory_order_seq_cst) > 0)
+		Futex::wakeAll(_pending);
+}
+
+
+bool ThreadPool::park()
+{
+	int epoch = _epoch.load(std::memory_order_acquire);
+	_sleepers.fetch_add(1, std::memory_order_seq_cst);
+	if (_queued.load(std::memory_order_seq_cst) > 0)
+	{
+		_sleepers.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+	if (_stopped.load(std::memory_order_seq_cst))
+	{
+		_sleepers.fetch_sub(1, std::memory_order_relaxed);
+		return false;
+	}
+	Futex::wait(_epoch, epoch);
+	_sleepers.fetch_sub(1, std::memory_order_relaxed);
+	return true;
+}
+
+
+void ThreadPool::wake(int count)
+{
+	_epoch.fetch_add(1, std::memory_order_release);
+	Futex::wake(_epoch, count);
+}
+
+
+void ThreadPool::joinAll()
+{
+	ASSERT(!PooledThread::current() || &PooledThread::current()->_pool != this);
+
+	_joiners.fetch_add(1, std::memory_order_seq_cst);
+	for (;;)
+	{
+		int pending = _pending.load(std::memory_order_seq_cst);
+		if (pending == 0) break;
+		Futex::wait(_pending, pending);
+	}
+	_joiners.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+ThreadPool& ThreadPool::defaultPool()
+{
+	static SingletonHolder<ThreadPool> sh;
+	return *sh.get();
+}
+
+
+int ThreadPool::cpuCount()
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (::sched_getaffinity(0, sizeof(set), &set) == 0)
+		return CPU_COUNT(&set);
+	long n = ::sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? static_cast<int>(n) : 1;
+}
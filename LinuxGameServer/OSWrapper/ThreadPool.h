@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Thread.h"
+#include "Runnable.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+class PooledThread;
+
+
+// Fixed set of worker threads sharing tasks by work stealing.
+//
+// Every worker owns one Chase-Lev deque per priority. Tasks started from a
+// worker go to the bottom of its own deque; tasks started from any other
+// thread go to a shared injection queue. An idle worker looks for the
+// highest priority task first in its own deque, then in the injection
+// queue, then by stealing from the top of another worker's deque. Workers
+// with nothing to do park on a futex and are woken one per new task.
+//
+// Tasks are meant to be short and non-blocking (pathfinding, AI,
+// persistence batches); long running loops should get their own Thread.
+class ThreadPool
+{
+public:
+	enum TaskPriority
+	{
+		TASK_PRIO_LOW,
+		TASK_PRIO_NORMAL,
+		TASK_PRIO_HIGH,
+		TASK_PRIO_COUNT
+	};
+
+	// Creates a pool with the given number of workers; 0 means one per CPU
+	// the process may run on.
+	explicit ThreadPool(int threads = 0, const std::string& name = "pool");
+
+	// Waits for all pending tasks, then stops the workers.
+	~ThreadPool();
+
+	void start(Runnable& target, TaskPriority prio = TASK_PRIO_NORMAL);
+
+	void start(RunnablePtr pTarget, TaskPriority prio = TASK_PRIO_NORMAL);
+
+	template <class Functor>
+	void startFunc(Functor&& fn, TaskPriority prio = TASK_PRIO_NORMAL)
+	{
+		schedule(new Thread::FunctorRunnable<typename std::decay<Functor>::type>(std::forward<Functor>(fn)), prio);
+	}
+
+	// Blocks until every task started so far has finished. Must not be
+	// called from a task running in this pool.
+	void joinAll();
+
+	int capacity() const;
+
+	int pending() const;
+
+	const std::string& name() const;
+
+	static ThreadPool& defaultPool();
+
+	static int cpuCount();
+
+private:
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator = (const ThreadPool&);
+
+	void schedule(Runnable* pTask, TaskPriority prio);
+	Runnable* findTask(PooledThread* pSelf);
+	void runTask(Runnable* pTask);
+	bool park();
+	void wake(int count);
+
+	std::string                _name;
+	std::vector<PooledThread*> _threads;
+	std::mutex                 _mutex;
+	std::deque<Runnable*>      _injected[TASK_PRIO_COUNT];
+	std::atomic<int>           _injectedCount[TASK_PRIO_COUNT];
+	std::atomic<int>           _queued;
+	std::atomic<int>           _pending;
+	std::atomic<int>           _sleepers;
+	std::atomic<int>           _joiners;
+	std::atomic<int>           _epoch;
+	std::atomic<bool>          _stopped;
+
+	friend class PooledThread;
+};
+
+
+//
+// inlines
+//
+inline int ThreadPool::capacity() const
+{
+	return static_cast<int>(_threads.size());
+}
+
+
+inline int ThreadPool::pending() const
+{
+	return _pending.load(std::memory_order_relaxed);
+}
+
+
+inline const std::string& ThreadPool::name() const
+{
+	return _name;
+}
@@ -1,15 +1,22 @@
 #include "Application.h"
+#include "MapConfiguration.h"
+#include "PropertyFileConfiguration.h"
+#include "IniFileConfiguration.h"
+#include "JSONConfiguration.h"
+#include "ConfigurationWatcher.h"
 #include "NumberFormatter.h"
+#include "TString.h"
 #include "File.h"
 #include "Path.h"
 #include "Logger.h"
+#include "Thread.h"
 
 
 Application* Application::_pInstance = 0;
 
 
 Application::Application() :
-	_pConfig(new Configuration),
+	_pConfig(new LayeredConfiguration),
 	_initialized(false),
 	_pLogger(&Logger::get("ApplicationStartup"))
 {
@@ -18,7 +25,7 @@ Application::Application() :
 
 
 Application::Application(int argc, char* argv[]) :
-	_pConfig(new Configuration),
+	_pConfig(new LayeredConfiguration),
 	_initialized(false),
 	_pLogger(&Logger::get("ApplicationStartup"))
 {
@@ -38,9 +45,18 @@ void Application::setup()
 	ASSERT(_pInstance == 0);
 
 	//_pConfig->add(new SystemConfiguration, PRIO_SYSTEM, false);
-	//_pConfig->add(new MapConfiguration, PRIO_APPLICATION, true);
+	_pConfig->add(new MapConfiguration, PRIO_APPLICATION, true);
 
 	//addSubsystem(new LoggingSubsystem);
+	try
+	{
+		addSubsystem(new ConfigurationWatcher);
+	}
+	catch (SystemException& exc)
+	{
+		// out of inotify instances; run without hot reload
+		_pLogger->warning(exc.displayText());
+	}
 
 	setUnixOptions(false);
 
@@ -94,6 +110,7 @@ const char* Application::name() const
 
 void Application::initialize(Application& self)
 {
+	configureThreads();
 	for (auto& pSub : _subsystems)
 	{
 		_pLogger->debug(std::string("Initializing subsystem: ") + pSub->name());
@@ -138,12 +155,58 @@ int Application::loadConfiguration(int priority)
 	int n = 0;
 	Path appPath;
 	getApplicationPath(appPath);
+	Path confPath;
+	if (findAppConfigFile(appPath.getBaseName(), "properties", confPath))
+	{
+		_pConfig->add(new PropertyFileConfiguration(confPath.toString()), priority, false);
+		++n;
+	}
+	if (findAppConfigFile(appPath.getBaseName(), "ini", confPath))
+	{
+		_pConfig->add(new IniFileConfiguration(confPath.toString()), priority, false);
+		++n;
+	}
+	if (findAppConfigFile(appPath.getBaseName(), "json", confPath))
+	{
+		_pConfig->add(new JSONConfiguration(confPath.toString()), priority, false);
+		++n;
+	}
+	if (n > 0)
+	{
+		if (!confPath.isAbsolute())
+			_pConfig->setString("application.configDir", confPath.absolute().parent().toString());
+		else
+			_pConfig->setString("application.configDir", confPath.parent().toString());
+	}
 	return n;
 }
 
 
 void Application::loadConfiguration(const std::string& path, int priority)
 {
+	Path confPath(path);
+	std::string ext = confPath.getExtension();
+	if (icompare(ext, std::string("properties")) == 0)
+	{
+		_pConfig->add(new PropertyFileConfiguration(confPath.toString()), priority, false);
+	}
+	else if (icompare(ext, std::string("ini")) == 0)
+	{
+		_pConfig->add(new IniFileConfiguration(confPath.toString()), priority, false);
+	}
+	else if (icompare(ext, std::string("json")) == 0)
+	{
+		_pConfig->add(new JSONConfiguration(confPath.toString()), priority, false);
+	}
+	else throw InvalidArgumentException("Unsupported configuration file type", ext);
+
+	if (!_pConfig->has("application.configDir"))
+	{
+		if (!confPath.isAbsolute())
+			_pConfig->setString("application.configDir", confPath.absolute().parent().toString());
+		else
+			_pConfig->setString("application.configDir", confPath.parent().toString());
+	}
 }
 
 
@@ -237,6 +300,32 @@ void Application::processOptions()
 }
 
 
+// Reads thread placements of the form
+//   application.threads.<name>.cpus     = 0-3,8
+//   application.threads.<name>.numaNode = 1
+// An invalid entry is logged and ignored; the threads it names just run
+// unplaced.
+void Application::configureThreads()
+{
+	Configuration::Keys names;
+	_pConfig->keys("application.threads", names);
+	for (const auto& name : names)
+	{
+		std::string base = "application.threads." + name;
+		try
+		{
+			std::vector<int> cpus = Thread::parseCpuList(_pConfig->getString(base + ".cpus", ""));
+			int node = _pConfig->getInt(base + ".numaNode", -1);
+			Thread::setPlacement(name, cpus, node);
+		}
+		catch (Exception& exc)
+		{
+			logger().warning("ignoring thread placement " + base + ": " + exc.displayText());
+		}
+	}
+}
+
+
 void Application::getApplicationPath(Path& appPath) const
 {
 	appPath = _command;
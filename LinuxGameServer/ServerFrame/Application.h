@@ -7,11 +7,12 @@
 #include <memory>
 
 #include "Subsystem.h"
-#include "Configuration.h"
+#include "LayeredConfiguration.h"
 #include "OptionManager.h"
 #include "Logger.h"
 #include "Path.h"
 #include "Timestamp.h"
+#include "Clock.h"
 #include "Timespan.h"
 #include "AutoPtr.h"
 
@@ -77,9 +78,9 @@ public:
 
 	std::string commandPath() const;
 
-	Configuration& config() const;
+	LayeredConfiguration& config() const;
 
-	Configuration::Ptr configPtr() const;
+	LayeredConfiguration::Ptr configPtr() const;
 
 	Logger& logger() const;
 
@@ -122,11 +123,12 @@ private:
 	void setArgs(const ArgVec& args);
 	void getApplicationPath(Path& path) const;
 	void processOptions();
+	void configureThreads();
 	bool findAppConfigFile(const std::string& appName, const std::string& extension, Path& path) const;
 	bool findAppConfigFile(const Path& basePath, const std::string& appName, const std::string& extension, Path& path) const;
 
 private:
-	typedef Configuration::Ptr ConfigPtr;
+	typedef LayeredConfiguration::Ptr ConfigPtr;
 	typedef Logger::Ptr LoggerPtr;
 
 	ConfigPtr       _pConfig;
@@ -139,6 +141,7 @@ private:
 
 	Logger* _pLogger;
 	Timestamp _startTime;
+	Clock _startClock;
 
 private:
 	friend class LoggingSubsystem;
@@ -173,13 +176,13 @@ inline bool Application::initialized() const
 }
 
 
-inline Configuration& Application::config() const
+inline LayeredConfiguration& Application::config() const
 {
-	return *const_cast<Configuration*>(_pConfig.get());
+	return *const_cast<LayeredConfiguration*>(_pConfig.get());
 }
 
 
-inline Configuration::Ptr Application::configPtr() const
+inline LayeredConfiguration::Ptr Application::configPtr() const
 {
 	return _pConfig;
 }
@@ -219,8 +222,7 @@ inline const Timestamp& Application::startTime() const
 
 inline Timespan Application::uptime() const
 {
-	Timestamp now;
-	Timespan uptime = now - _startTime;
+	Timespan uptime = _startClock.elapsed();
 
 	return uptime;
 }
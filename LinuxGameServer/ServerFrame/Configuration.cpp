@@ -8,7 +8,8 @@
 
 Configuration::Configuration() :
 	_depth(0),
-	_eventsEnabled(true)
+	_eventsEnabled(true),
+	_version(1)
 {
 }
 
@@ -44,8 +45,8 @@ std::string Configuration::getString(const std::string& key) const
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return internalExpand(value);
+	if (getExpanded(key, value))
+		return value;
 	else
 		throw NotFoundException(key);
 }
@@ -56,8 +57,8 @@ std::string Configuration::getString(const std::string& key, const std::string&
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return internalExpand(value);
+	if (getExpanded(key, value))
+		return value;
 	else
 		return defaultValue;
 }
@@ -93,8 +94,8 @@ Int32 Configuration::getInt(const std::string& key) const
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return parseInt(internalExpand(value));
+	if (getExpanded(key, value))
+		return parseInt(value);
 	else
 		throw NotFoundException(key);
 }
@@ -105,8 +106,8 @@ Int32 Configuration::getInt(const std::string& key, Int32 defaultValue) const
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return parseInt(internalExpand(value));
+	if (getExpanded(key, value))
+		return parseInt(value);
 	else
 		return defaultValue;
 }
@@ -117,8 +118,8 @@ UInt32 Configuration::getUInt(const std::string& key) const
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return parseUInt(internalExpand(value));
+	if (getExpanded(key, value))
+		return parseUInt(value);
 	else
 		throw NotFoundException(key);
 }
@@ -129,8 +130,8 @@ UInt32 Configuration::getUInt(const std::string& key, UInt32 defaultValue) const
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return parseUInt(internalExpand(value));
+	if (getExpanded(key, value))
+		return parseUInt(value);
 	else
 		return defaultValue;
 }
@@ -141,8 +142,8 @@ Int64 Configuration::getInt64(const std::string& key) const
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return parseInt64(internalExpand(value));
+	if (getExpanded(key, value))
+		return parseInt64(value);
 	else
 		throw NotFoundException(key);
 }
@@ -153,8 +154,8 @@ Int64 Configuration::getInt64(const std::string& key, Int64 defaultValue) const
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return parseInt64(internalExpand(value));
+	if (getExpanded(key, value))
+		return parseInt64(value);
 	else
 		return defaultValue;
 }
@@ -165,8 +166,8 @@ UInt64 Configuration::getUInt64(const std::string& key) const
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return parseUInt64(internalExpand(value));
+	if (getExpanded(key, value))
+		return parseUInt64(value);
 	else
 		throw NotFoundException(key);
 }
@@ -177,8 +178,8 @@ UInt64 Configuration::getUInt64(const std::string& key, UInt64 defaultValue) con
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return parseUInt64(internalExpand(value));
+	if (getExpanded(key, value))
+		return parseUInt64(value);
 	else
 		return defaultValue;
 }
@@ -189,8 +190,8 @@ double Configuration::getDouble(const std::string& key) const
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return NumberParser::parseFloat(internalExpand(value));
+	if (getExpanded(key, value))
+		return NumberParser::parseDouble(value);
 	else
 		throw NotFoundException(key);
 }
@@ -201,8 +202,8 @@ double Configuration::getDouble(const std::string& key, double defaultValue) con
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return NumberParser::parseFloat(internalExpand(value));
+	if (getExpanded(key, value))
+		return NumberParser::parseDouble(value);
 	else
 		return defaultValue;
 }
@@ -213,8 +214,8 @@ bool Configuration::getBool(const std::string& key) const
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return parseBool(internalExpand(value));
+	if (getExpanded(key, value))
+		return parseBool(value);
 	else
 		throw NotFoundException(key);
 }
@@ -225,8 +226,8 @@ bool Configuration::getBool(const std::string& key, bool defaultValue) const
 	std::unique_lock<std::mutex> lock(_mutex);
 
 	std::string value;
-	if (getRaw(key, value))
-		return parseBool(internalExpand(value));
+	if (getExpanded(key, value))
+		return parseBool(value);
 	else
 		return defaultValue;
 }
@@ -251,16 +252,12 @@ void Configuration::setUInt(const std::string& key, UInt32 value)
 
 void Configuration::setInt64(const std::string& key, Int64 value)
 {
-	std::unique_lock<std::mutex> lock(_mutex);
-
 	setRawWithEvent(key, NumberFormatter::format(value));
 }
 
 
 void Configuration::setUInt64(const std::string& key, UInt64 value)
 {
-	std::unique_lock<std::mutex> lock(_mutex);
-
 	setRawWithEvent(key, NumberFormatter::format(value));
 }
 
@@ -321,7 +318,7 @@ std::string Configuration::expand(const std::string& value) const
 {
 	std::unique_lock<std::mutex> lock(_mutex);
 
-	return internalExpand(value);
+	return internalExpand(value, std::string());
 }
 
 
@@ -329,16 +326,17 @@ void Configuration::remove(const std::string& key)
 {
 	if (_eventsEnabled)
 	{
-		//propertyRemoving(this, key);
+		propertyRemoving(this, key);
 	}
 	{
 
 		std::unique_lock<std::mutex> lock(_mutex);
 		removeRaw(key);
+		invalidateSubtree(key);
 	}
 	if (_eventsEnabled)
 	{
-		//propertyRemoved(this, key);
+		propertyRemoved(this, key);
 	}
 }
 
@@ -361,45 +359,158 @@ void Configuration::removeRaw(const std::string& key)
 }
 
 
-std::string Configuration::internalExpand(const std::string& value) const
+void Configuration::entries(Entries& range) const
+{
+	collectEntries(std::string(), range);
+}
+
+
+void Configuration::collectEntries(const std::string& key, Entries& range) const
+{
+	Keys subKeys;
+	enumerate(key, subKeys);
+	for (const auto& subKey : subKeys)
+	{
+		std::string fullKey = key.empty() ? subKey : key + '.' + subKey;
+		std::string value;
+		if (getRaw(fullKey, value))
+			range.push_back(Entry(fullKey, value));
+		collectEntries(fullKey, range);
+	}
+}
+
+
+void Configuration::uncache(const std::string& key)
+{
+	_expandCache.erase(key);
+
+	DependencyMap::iterator it = _dependents.find(key);
+	if (it != _dependents.end())
+	{
+		std::set<std::string> dependents;
+		dependents.swap(it->second);
+		_dependents.erase(it);
+		for (const auto& dependent : dependents)
+		{
+			uncache(dependent);
+		}
+	}
+}
+
+
+bool Configuration::getExpanded(const std::string& key, std::string& value) const
+{
+	ExpandCache::const_iterator it = _expandCache.find(key);
+	if (it != _expandCache.end())
+	{
+		value = it->second;
+		return true;
+	}
+	if (!getRaw(key, value))
+		return false;
+	if (value.find("${") != std::string::npos)
+	{
+		value = internalExpand(value, key);
+		_expandCache[key] = value;
+	}
+	return true;
+}
+
+
+void Configuration::invalidate(const std::string& key)
+{
+	uncache(key);
+	_version.fetch_add(1, std::memory_order_release);
+}
+
+
+void Configuration::invalidateSubtree(const std::string& key)
+{
+	std::string prefix = key + '.';
+	Keys stale;
+	for (const auto& p : _expandCache)
+	{
+		if (p.first.compare(0, prefix.size(), prefix) == 0) stale.push_back(p.first);
+	}
+	for (const auto& p : _dependents)
+	{
+		if (p.first.compare(0, prefix.size(), prefix) == 0) stale.push_back(p.first);
+	}
+	uncache(key);
+	for (const auto& k : stale)
+	{
+		uncache(k);
+	}
+	_version.fetch_add(1, std::memory_order_release);
+}
+
+
+void Configuration::invalidateAll()
+{
+	_expandCache.clear();
+	_dependents.clear();
+	_version.fetch_add(1, std::memory_order_release);
+}
+
+
+void Configuration::notifyReset()
+{
+	if (_eventsEnabled)
+	{
+		const UInt32 version = this->version();
+		propertiesReset(this, version);
+	}
+}
+
+
+std::string Configuration::internalExpand(const std::string& value, const std::string& owner) const
 {
 	AutoCounter counter(_depth);
 	if (_depth > 10) throw CircularReferenceException("Too many property references encountered");
-	return uncheckedExpand(value);
+	return uncheckedExpand(value, owner);
 }
 
 
-std::string Configuration::uncheckedExpand(const std::string& value) const
+std::string Configuration::uncheckedExpand(const std::string& value, const std::string& owner) const
 {
 	std::string result;
-	std::string::const_iterator it = value.begin();
-	std::string::const_iterator end = value.end();
-	while (it != end)
+	result.reserve(value.size());
+	std::string::size_type pos = 0;
+	std::string::size_type end = value.size();
+	while (pos < end)
 	{
-		if (*it == '$')
+		std::string::size_type dollar = value.find('$', pos);
+		if (dollar == std::string::npos)
+		{
+			result.append(value, pos, std::string::npos);
+			break;
+		}
+		result.append(value, pos, dollar - pos);
+		pos = dollar + 1;
+		if (pos < end && value[pos] == '{')
 		{
-			++it;
-			if (it != end && *it == '{')
+			++pos;
+			std::string::size_type close = value.find('}', pos);
+			if (close == std::string::npos) close = end;
+			std::string prop(value, pos, close - pos);
+			pos = close < end ? close + 1 : end;
+			if (!owner.empty())
+			{
+				_dependents[prop].insert(owner);
+			}
+			std::string expanded;
+			if (getExpanded(prop, expanded))
+			{
+				result.append(expanded);
+			}
+			else
 			{
-				++it;
-				std::string prop;
-				while (it != end && *it != '}') prop += *it++;
-				if (it != end) ++it;
-				std::string value;
-				if (getRaw(prop, value))
-				{
-					result.append(internalExpand(value));
-				}
-				else
-				{
-					result.append("${");
-					result.append(prop);
-					result.append("}");
-				}
+				result.append("${");
+				result.append(prop);
+				result.append("}");
 			}
-			else result += '$';
 		}
-		else result += *it++;
+		else result += '$';
 	}
 	return result;
 }
@@ -468,14 +579,15 @@ void Configuration::setRawWithEvent(const std::string& key, std::string value)
 	KeyValue kv(key, value);
 	if (_eventsEnabled)
 	{
-		//propertyChanging(this, kv);
+		propertyChanging(this, kv);
 	}
 	{
 		std::unique_lock<std::mutex> lock(_mutex);
 		setRaw(key, value);
+		invalidate(key);
 	}
 	if (_eventsEnabled)
 	{
-		//propertyChanged(this, kv);
+		propertyChanged(this, kv);
 	}
 }
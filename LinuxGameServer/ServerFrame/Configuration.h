@@ -4,17 +4,23 @@
 #include "RefCountedObject.h"
 #include "Types.h"
 #include "AutoPtr.h"
+#include "BasicEvent.h"
 
 #include <vector>
 #include <string>
+#include <set>
+#include <unordered_map>
 #include <mutex>
 #include <memory>
+#include <atomic>
 
 
 class Configuration : public RefCountedObject
 {
 public:
 	using Keys = std::vector<std::string>;
+	using Entry = std::pair<std::string, std::string>;
+	using Entries = std::vector<Entry>;
 	using Ptr = AutoPtr<Configuration>;
 
 	friend Ptr;
@@ -48,14 +54,21 @@ public:
 		std::string& _value;
 	};
 
+	template <typename T>
+	class Handle;
+
 public:
 	Configuration();
 
 public:
-	//BasicEvent<KeyValue> propertyChanging;
-	//BasicEvent<const KeyValue> propertyChanged;
-	//BasicEvent<const std::string> propertyRemoving;
-	//BasicEvent<const std::string> propertyRemoved;
+	BasicEvent<KeyValue> propertyChanging;
+	BasicEvent<const KeyValue> propertyChanged;
+	BasicEvent<const std::string> propertyRemoving;
+	BasicEvent<const std::string> propertyRemoved;
+
+	// Fired after all properties were replaced at once (clear, load)
+	// without per-key events. Carries the new version().
+	BasicEvent<const UInt32> propertiesReset;
 
 public:
 	bool hasProperty(const std::string& key) const;
@@ -87,6 +100,11 @@ public:
 	bool getBool(const std::string& key) const;
 	bool getBool(const std::string& key, bool defaultValue) const;
 
+	template <typename T>
+	Handle<T> handle(const std::string& key, const T& defaultValue);
+
+	UInt32 version() const;
+
 public:
 	virtual void setString(const std::string& key, const std::string& value);
 
@@ -130,6 +148,16 @@ protected:
 	{
 		;
 	}
+	virtual void entries(Entries& range) const;
+
+	void invalidate(const std::string& key);
+	void invalidateSubtree(const std::string& key);
+	void invalidateAll();
+
+	// Fires propertiesReset; call after invalidateAll(), without the lock.
+	void notifyReset();
+
+	std::mutex& mutex() const;
 
 protected:
 	static Int32 parseInt(const std::string& value);
@@ -146,14 +174,146 @@ protected:
 	virtual ~Configuration();
 
 private:
-	std::string internalExpand(const std::string& value) const;
-	std::string uncheckedExpand(const std::string& value) const;
+	using ExpandCache = std::unordered_map<std::string, std::string>;
+	using DependencyMap = std::unordered_map<std::string, std::set<std::string>>;
+
+	void collectEntries(const std::string& key, Entries& range) const;
+	void uncache(const std::string& key);
+	bool getExpanded(const std::string& key, std::string& value) const;
+	std::string internalExpand(const std::string& value, const std::string& owner) const;
+	std::string uncheckedExpand(const std::string& value, const std::string& owner) const;
 
 	Configuration(const Configuration&);
 	Configuration& operator = (const Configuration&);
 
+	friend class LayeredConfiguration;
+
 private:
 	mutable int _depth;
 	bool        _eventsEnabled;
 	mutable std::mutex _mutex;
+	std::atomic<UInt32> _version;
+
+	mutable ExpandCache   _expandCache;
+	mutable DependencyMap _dependents;
 };
+
+
+// Caches the parsed value of a property and re-reads it only after the
+// configuration version has changed. Not meant to be shared between threads.
+template <typename T>
+class Configuration::Handle
+{
+public:
+	Handle() :
+		_defaultValue(),
+		_value(),
+		_version(0)
+	{
+	}
+
+	Handle(Configuration::Ptr pConfig, const std::string& key, const T& defaultValue) :
+		_pConfig(pConfig),
+		_key(key),
+		_defaultValue(defaultValue),
+		_value(defaultValue),
+		_version(0)
+	{
+	}
+
+	const T& value() const
+	{
+		UInt32 version = _pConfig->version();
+		if (version != _version)
+		{
+			_value = fetch();
+			_version = version;
+		}
+		return _value;
+	}
+
+	operator const T& () const
+	{
+		return value();
+	}
+
+	const std::string& key() const
+	{
+		return _key;
+	}
+
+	bool isNull() const
+	{
+		return _pConfig.isNull();
+	}
+
+private:
+	T fetch() const;
+
+	Configuration::Ptr _pConfig;
+	std::string        _key;
+	T                  _defaultValue;
+	mutable T          _value;
+	mutable UInt32     _version;
+};
+
+
+template <> inline std::string Configuration::Handle<std::string>::fetch() const
+{
+	return _pConfig->getString(_key, _defaultValue);
+}
+
+
+template <> inline Int32 Configuration::Handle<Int32>::fetch() const
+{
+	return _pConfig->getInt(_key, _defaultValue);
+}
+
+
+template <> inline UInt32 Configuration::Handle<UInt32>::fetch() const
+{
+	return _pConfig->getUInt(_key, _defaultValue);
+}
+
+
+template <> inline Int64 Configuration::Handle<Int64>::fetch() const
+{
+	return _pConfig->getInt64(_key, _defaultValue);
+}
+
+
+template <> inline UInt64 Configuration::Handle<UInt64>::fetch() const
+{
+	return _pConfig->getUInt64(_key, _defaultValue);
+}
+
+
+template <> inline double Configuration::Handle<double>::fetch() const
+{
+	return _pConfig->getDouble(_key, _defaultValue);
+}
+
+
+template <> inline bool Configuration::Handle<bool>::fetch() const
+{
+	return _pConfig->getBool(_key, _defaultValue);
+}
+
+
+template <typename T>
+inline Configuration::Handle<T> Configuration::handle(const std::string& key, const T& defaultValue)
+{
+	return Handle<T>(Ptr(this, true), key, defaultValue);
+}
+
+
+inline UInt32 Configuration::version() const
+{
+	return _version.load(std::memory_order_acquire);
+}
+
+
+inline std::mutex& Configuration::mutex() const
+{
+	return _mutex;
+}
@@ -0,0 +1,230 @@
+#include "ConfigurationWatcher.h"
+#include "Application.h"
+#include "BaseException.h"
+#include "Path.h"
+
+#include <set>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+
+
+ConfigurationWatcher::ConfigurationWatcher() :
+	_inotifyFd(-1),
+	_wakeupFd(-1),
+	_thread("ConfigurationWatcher"),
+	_running(false)
+{
+	_inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_inotifyFd < 0)
+		throw SystemException("cannot create inotify instance");
+	_wakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_wakeupFd < 0)
+	{
+		::close(_inotifyFd);
+		throw SystemException("cannot create eventfd");
+	}
+}
+
+
+ConfigurationWatcher::~ConfigurationWatcher()
+{
+	stop();
+	::close(_wakeupFd);
+	::close(_inotifyFd);
+}
+
+
+const char* ConfigurationWatcher::name() const
+{
+	return "ConfigurationWatcher";
+}
+
+
+void ConfigurationWatcher::initialize(Application& app)
+{
+	if (!app.config().getBool("application.watchConfiguration", true)) return;
+
+	LayeredConfiguration::Ptr pLayered = app.configPtr();
+	std::vector<Configuration::Ptr> configs;
+	pLayered->configurations(configs);
+	for (auto& pConfig : configs)
+	{
+		MappedFileConfiguration::Ptr pFileConfig = pConfig.cast<MappedFileConfiguration>();
+		if (pFileConfig) watch(pLayered, pFileConfig);
+	}
+	start();
+}
+
+
+void ConfigurationWatcher::uninitialize()
+{
+	stop();
+}
+
+
+void ConfigurationWatcher::watch(LayeredConfiguration::Ptr pLayered, MappedFileConfiguration::Ptr pConfig)
+{
+	Path path(pConfig->path());
+	path.makeAbsolute();
+
+	// Watch the directory rather than the file, so that files replaced by
+	// rename are still seen. IN_CREATE is left out on purpose: a file that
+	// was just created is usually still being written.
+	int wd = ::inotify_add_watch(_inotifyFd, path.parent().toString().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (wd < 0)
+		throw SystemException("cannot watch configuration directory", path.parent().toString());
+
+	Watch watch;
+	watch.pLayered = pLayered;
+	watch.pConfig = pConfig;
+	watch.fileName = path.getFileName();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_watches[wd].push_back(watch);
+}
+
+
+void ConfigurationWatcher::start()
+{
+	if (_running) return;
+
+	_running = true;
+	_thread.startFunc([this] { run(); });
+}
+
+
+void ConfigurationWatcher::stop()
+{
+	if (!_running) return;
+
+	_running = false;
+	UInt64 one = 1;
+	ssize_t n = ::write(_wakeupFd, &one, sizeof(one));
+	(void)n;
+	_thread.join();
+}
+
+
+void ConfigurationWatcher::run()
+{
+	// The watcher starts before ServerApplication blocks the termination
+	// signals for sigwait(); keep them from being delivered here instead.
+	sigset_t sset;
+	sigemptyset(&sset);
+	sigaddset(&sset, SIGINT);
+	sigaddset(&sset, SIGQUIT);
+	sigaddset(&sset, SIGTERM);
+	sigaddset(&sset, SIGHUP);
+	pthread_sigmask(SIG_BLOCK, &sset, 0);
+
+	char buffer[16 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	struct pollfd fds[2];
+	fds[0].fd = _inotifyFd;
+	fds[0].events = POLLIN;
+	fds[1].fd = _wakeupFd;
+	fds[1].events = POLLIN;
+
+	while (_running)
+	{
+		int rc = ::poll(fds, 2, -1);
+		if (rc < 0)
+		{
+			if (errno == EINTR) continue;
+			break;
+		}
+		if (!_running) break;
+		if (!(fds[0].revents & POLLIN)) continue;
+
+		std::set<std::pair<int, std::string>> changed;
+		ssize_t len;
+		while ((len = ::read(_inotifyFd, buffer, sizeof(buffer))) > 0)
+		{
+			const char* ptr = buffer;
+			while (ptr < buffer + len)
+			{
+				const struct inotify_event* pEvent = reinterpret_cast<const struct inotify_event*>(ptr);
+				if (pEvent->len > 0 && (pEvent->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)))
+					changed.insert(std::make_pair(pEvent->wd, std::string(pEvent->name)));
+				ptr += sizeof(struct inotify_event) + pEvent->len;
+			}
+		}
+
+		// Reload on copies, without the lock: reload() fires the change
+		// events, and a listener may well call watch().
+		std::vector<std::pair<int, Watch>> pending;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			for (const auto& c : changed)
+			{
+				WatchMap::iterator it = _watches.find(c.first);
+				if (it == _watches.end()) continue;
+				for (const auto& watch : it->second)
+				{
+					if (watch.fileName == c.second) pending.push_back(std::make_pair(c.first, watch));
+				}
+			}
+		}
+		for (auto& p : pending)
+		{
+			MappedFileConfiguration::Ptr pOld = p.second.pConfig;
+			reload(p.second);
+			if (p.second.pConfig == pOld) continue;
+
+			std::unique_lock<std::mutex> lock(_mutex);
+			for (auto& watch : _watches[p.first])
+			{
+				if (watch.pConfig == pOld && watch.pLayered == p.second.pLayered)
+					watch.pConfig = p.second.pConfig;
+			}
+		}
+	}
+}
+
+
+void ConfigurationWatcher::reload(Watch& watch)
+{
+	MappedFileConfiguration::Ptr pConfig;
+	try
+	{
+		pConfig = watch.pConfig->reload();
+	}
+	catch (Exception& exc)
+	{
+		Logger::get(name()).error("cannot reload " + watch.pConfig->path() + ": " + exc.displayText());
+		return;
+	}
+
+	Configuration::Keys changed;
+	Configuration::Keys removed;
+	pConfig->diff(*watch.pConfig, changed, removed);
+	if (changed.empty() && removed.empty()) return;
+
+	MappedFileConfiguration::Ptr pOld = watch.pConfig;
+	if (!watch.pLayered->replaceConfiguration(pOld, pConfig)) return;
+	watch.pConfig = pConfig;
+
+	Logger::get(name()).information("reloaded " + pConfig->path());
+
+	LayeredConfiguration& layered = *watch.pLayered;
+	if (!layered.eventsEnabled()) return;
+	for (const auto& key : changed)
+	{
+		std::string value = layered.getRawString(key, std::string());
+		const Configuration::KeyValue kv(key, value);
+		layered.propertyChanged(&layered, kv);
+	}
+	for (const auto& key : removed)
+	{
+		if (layered.has(key))
+		{
+			std::string value = layered.getRawString(key);
+			const Configuration::KeyValue kv(key, value);
+			layered.propertyChanged(&layered, kv);
+		}
+		else layered.propertyRemoved(&layered, key);
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Subsystem.h"
+#include "LayeredConfiguration.h"
+#include "MappedFileConfiguration.h"
+#include "Thread.h"
+
+#include <mutex>
+#include <atomic>
+#include <map>
+#include <vector>
+
+
+// Reloads file based configuration layers when their files change.
+// A changed file is parsed on the watcher thread and swapped into the
+// layered configuration in one step, then propertyChanged/propertyRemoved
+// are fired on the layered configuration for every key that differs.
+// Only a finished write (close after writing, or rename into place)
+// triggers a reload; unless the layer was loaded with LOAD_MAP, the new
+// layer owns a private copy of the file, so the replaced one never changes
+// while it is still being read.
+//
+// Every Application registers a watcher, which watches the file layers
+// loaded before the subsystems are initialized. Set
+// application.watchConfiguration = false to turn hot reload off.
+//
+// Lookups on the layered configuration still take its mutex; code that
+// reads a property per frame should keep a Configuration::Handle, which
+// only rereads after a reload has changed the version.
+class ConfigurationWatcher : public Subsystem
+{
+public:
+	using Ptr = AutoPtr<ConfigurationWatcher>;
+
+	ConfigurationWatcher();
+
+	const char* name() const;
+
+	void watch(LayeredConfiguration::Ptr pLayered, MappedFileConfiguration::Ptr pConfig);
+
+	void start();
+
+	void stop();
+
+protected:
+	void initialize(Application& app);
+
+	void uninitialize();
+
+	~ConfigurationWatcher();
+
+private:
+	struct Watch
+	{
+		LayeredConfiguration::Ptr    pLayered;
+		MappedFileConfiguration::Ptr pConfig;
+		std::string                  fileName;
+	};
+
+	using WatchVec = std::vector<Watch>;
+	using WatchMap = std::map<int, WatchVec>;
+
+	void run();
+	void reload(Watch& watch);
+
+	int      _inotifyFd;
+	int      _wakeupFd;
+	WatchMap _watches;
+
+	Thread            _thread;
+	std::atomic<bool> _running;
+	std::mutex        _mutex;
+};
@@ -0,0 +1,103 @@
+#include "IniFileConfiguration.h"
+
+
+namespace
+{
+	inline bool isBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\f';
+	}
+
+	inline bool isSpace(char c)
+	{
+		return isBlank(c) || c == '\n' || c == '\r';
+	}
+
+	inline bool isEol(char c)
+	{
+		return c == '\n' || c == '\r';
+	}
+
+	std::string_view trimmed(const char* begin, const char* end)
+	{
+		while (begin != end && isBlank(*begin)) ++begin;
+		while (end != begin && isBlank(end[-1])) --end;
+		return std::string_view(begin, end - begin);
+	}
+}
+
+
+IniFileConfiguration::IniFileConfiguration()
+{
+}
+
+
+IniFileConfiguration::IniFileConfiguration(const std::string& path)
+{
+	load(path);
+}
+
+
+IniFileConfiguration::~IniFileConfiguration()
+{
+}
+
+
+MappedFileConfiguration* IniFileConfiguration::create() const
+{
+	return new IniFileConfiguration;
+}
+
+
+void IniFileConfiguration::parse(const char* begin, const char* end)
+{
+	std::string fullKey;
+	std::string::size_type sectionSize = 0;
+
+	const char* it = begin;
+	while (it != end)
+	{
+		while (it != end && isSpace(*it)) ++it;
+		if (it == end) break;
+
+		if (*it == ';' || *it == '#')
+		{
+			while (it != end && !isEol(*it)) ++it;
+		}
+		else if (*it == '[')
+		{
+			const char* sectionBegin = ++it;
+			while (it != end && *it != ']' && !isEol(*it)) ++it;
+			if (it == end || *it != ']')
+				syntaxError("Missing ']' in section header", sectionBegin);
+			std::string_view section = trimmed(sectionBegin, it);
+			fullKey.assign(section.data(), section.size());
+			if (!fullKey.empty()) fullKey += '.';
+			sectionSize = fullKey.size();
+			while (it != end && !isEol(*it)) ++it;
+		}
+		else
+		{
+			const char* keyBegin = it;
+			while (it != end && *it != '=' && !isEol(*it)) ++it;
+			std::string_view key = trimmed(keyBegin, it);
+			std::string_view value;
+			if (it != end && *it == '=')
+			{
+				const char* valueBegin = ++it;
+				while (it != end && !isEol(*it)) ++it;
+				value = trimmed(valueBegin, it);
+			}
+			if (sectionSize == 0)
+			{
+				store(key, value);
+			}
+			else
+			{
+				fullKey.resize(sectionSize);
+				fullKey.append(key.data(), key.size());
+				store(intern(fullKey), value);
+			}
+		}
+	}
+}
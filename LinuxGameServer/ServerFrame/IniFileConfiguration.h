@@ -0,0 +1,20 @@
+#pragma once
+
+#include "MappedFileConfiguration.h"
+
+
+class IniFileConfiguration : public MappedFileConfiguration
+{
+public:
+	using Ptr = AutoPtr<IniFileConfiguration>;
+	friend Ptr;
+
+	IniFileConfiguration();
+	IniFileConfiguration(const std::string& path);
+
+protected:
+	MappedFileConfiguration* create() const;
+	void parse(const char* begin, const char* end);
+
+	~IniFileConfiguration();
+};
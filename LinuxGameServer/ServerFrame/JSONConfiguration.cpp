@@ -0,0 +1,314 @@
+#include "JSONConfiguration.h"
+#include "NumberFormatter.h"
+
+
+class JSONConfiguration::Parser
+{
+public:
+	enum
+	{
+		MAX_DEPTH = 256
+	};
+
+	Parser(JSONConfiguration& config, const char* begin, const char* end) :
+		_config(config),
+		_it(begin),
+		_end(end),
+		_depth(0)
+	{
+	}
+
+	void parse()
+	{
+		skipSpace();
+		if (_it == _end) return;
+		if (*_it != '{' && *_it != '[')
+			error("Expected object or array");
+		parseValue();
+		skipSpace();
+		if (_it != _end)
+			error("Unexpected data after JSON document");
+	}
+
+private:
+	void parseValue()
+	{
+		skipSpace();
+		if (_it == _end) error("Unexpected end of JSON document");
+
+		switch (*_it)
+		{
+		case '{':
+			parseObject();
+			break;
+		case '[':
+			parseArray();
+			break;
+		case '"':
+		{
+			bool decoded;
+			std::string_view value = parseString(decoded);
+			store(decoded ? _config.intern(value) : value);
+			break;
+		}
+		case 't':
+			store(parseLiteral("true"));
+			break;
+		case 'f':
+			store(parseLiteral("false"));
+			break;
+		case 'n':
+			parseLiteral("null");
+			store(std::string_view());
+			break;
+		default:
+			store(parseNumber());
+			break;
+		}
+	}
+
+	void parseObject()
+	{
+		enter();
+		++_it;
+		skipSpace();
+		if (_it != _end && *_it == '}')
+		{
+			++_it;
+			--_depth;
+			return;
+		}
+		for (;;)
+		{
+			skipSpace();
+			if (_it == _end || *_it != '"') error("Expected member name");
+			bool decoded;
+			std::string_view name = parseString(decoded);
+			std::string::size_type mark = _key.size();
+			if (mark > 0) _key += '.';
+			_key.append(name.data(), name.size());
+
+			skipSpace();
+			if (_it == _end || *_it != ':') error("Expected ':'");
+			++_it;
+			parseValue();
+			_key.resize(mark);
+
+			skipSpace();
+			if (_it != _end && *_it == ',')
+			{
+				++_it;
+				continue;
+			}
+			if (_it != _end && *_it == '}')
+			{
+				++_it;
+				break;
+			}
+			error("Expected ',' or '}'");
+		}
+		--_depth;
+	}
+
+	void parseArray()
+	{
+		enter();
+		++_it;
+		skipSpace();
+		if (_it != _end && *_it == ']')
+		{
+			++_it;
+			--_depth;
+			return;
+		}
+		for (int index = 0; ; ++index)
+		{
+			std::string::size_type mark = _key.size();
+			_key += '[';
+			NumberFormatter::append(_key, index);
+			_key += ']';
+			parseValue();
+			_key.resize(mark);
+
+			skipSpace();
+			if (_it != _end && *_it == ',')
+			{
+				++_it;
+				continue;
+			}
+			if (_it != _end && *_it == ']')
+			{
+				++_it;
+				break;
+			}
+			error("Expected ',' or ']'");
+		}
+		--_depth;
+	}
+
+	// Objects and arrays recurse, so a deeply nested (or truncated) document
+	// would otherwise overflow the stack instead of failing to parse.
+	void enter()
+	{
+		if (++_depth > MAX_DEPTH) error("JSON document nested too deeply");
+	}
+
+	std::string_view parseString(bool& decoded)
+	{
+		const char* begin = ++_it;
+		while (_it != _end && *_it != '"' && *_it != '\\') ++_it;
+		if (_it == _end) error("Unterminated string");
+		if (*_it == '"')
+		{
+			decoded = false;
+			return std::string_view(begin, _it++ - begin);
+		}
+
+		decoded = true;
+		_scratch.assign(begin, _it);
+		while (_it != _end && *_it != '"')
+		{
+			char c = *_it++;
+			if (c != '\\')
+			{
+				_scratch += c;
+				continue;
+			}
+			if (_it == _end) break;
+			c = *_it++;
+			switch (c)
+			{
+			case 'b': _scratch += '\b'; break;
+			case 'f': _scratch += '\f'; break;
+			case 'n': _scratch += '\n'; break;
+			case 'r': _scratch += '\r'; break;
+			case 't': _scratch += '\t'; break;
+			case 'u': appendUnicode(); break;
+			default:  _scratch += c; break;
+			}
+		}
+		if (_it == _end) error("Unterminated string");
+		++_it;
+		return _scratch;
+	}
+
+	void appendUnicode()
+	{
+		UInt32 cp = parseHex4();
+		if (cp >= 0xDC00 && cp <= 0xDFFF) error("Unpaired surrogate in unicode escape");
+		if (cp >= 0xD800 && cp <= 0xDBFF)
+		{
+			if (_end - _it < 6 || _it[0] != '\\' || _it[1] != 'u') error("Unpaired surrogate in unicode escape");
+			_it += 2;
+			UInt32 low = parseHex4();
+			if (low < 0xDC00 || low > 0xDFFF) error("Unpaired surrogate in unicode escape");
+			cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+		}
+		if (cp < 0x80)
+		{
+			_scratch += static_cast<char>(cp);
+		}
+		else if (cp < 0x800)
+		{
+			_scratch += static_cast<char>(0xC0 | (cp >> 6));
+			_scratch += static_cast<char>(0x80 | (cp & 0x3F));
+		}
+		else if (cp < 0x10000)
+		{
+			_scratch += static_cast<char>(0xE0 | (cp >> 12));
+			_scratch += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+			_scratch += static_cast<char>(0x80 | (cp & 0x3F));
+		}
+		else
+		{
+			_scratch += static_cast<char>(0xF0 | (cp >> 18));
+			_scratch += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+			_scratch += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+			_scratch += static_cast<char>(0x80 | (cp & 0x3F));
+		}
+	}
+
+	UInt32 parseHex4()
+	{
+		if (_end - _it < 4) error("Invalid unicode escape");
+		UInt32 cp = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			char c = *_it++;
+			cp <<= 4;
+			if (c >= '0' && c <= '9') cp |= c - '0';
+			else if (c >= 'a' && c <= 'f') cp |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F') cp |= c - 'A' + 10;
+			else error("Invalid unicode escape");
+		}
+		return cp;
+	}
+
+	std::string_view parseLiteral(std::string_view literal)
+	{
+		if (static_cast<std::size_t>(_end - _it) < literal.size() || literal.compare(0, literal.size(), _it, literal.size()) != 0)
+			error("Invalid literal");
+		std::string_view value(_it, literal.size());
+		_it += literal.size();
+		return value;
+	}
+
+	std::string_view parseNumber()
+	{
+		const char* begin = _it;
+		while (_it != _end && ((*_it >= '0' && *_it <= '9') || *_it == '-' || *_it == '+' || *_it == '.' || *_it == 'e' || *_it == 'E')) ++_it;
+		if (_it == begin) error("Unexpected character");
+		return std::string_view(begin, _it - begin);
+	}
+
+	void store(std::string_view value)
+	{
+		_config.store(_config.intern(_key), value);
+	}
+
+	void skipSpace()
+	{
+		while (_it != _end && (*_it == ' ' || *_it == '\t' || *_it == '\n' || *_it == '\r')) ++_it;
+	}
+
+	[[noreturn]] void error(const char* msg)
+	{
+		_config.syntaxError(msg, _it);
+	}
+
+	JSONConfiguration& _config;
+	const char*        _it;
+	const char*        _end;
+	int                _depth;
+	std::string        _key;
+	std::string        _scratch;
+};
+
+
+JSONConfiguration::JSONConfiguration()
+{
+}
+
+
+JSONConfiguration::JSONConfiguration(const std::string& path)
+{
+	load(path);
+}
+
+
+JSONConfiguration::~JSONConfiguration()
+{
+}
+
+
+MappedFileConfiguration* JSONConfiguration::create() const
+{
+	return new JSONConfiguration;
+}
+
+
+void JSONConfiguration::parse(const char* begin, const char* end)
+{
+	Parser parser(*this, begin, end);
+	parser.parse();
+}
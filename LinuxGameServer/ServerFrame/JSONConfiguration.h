@@ -0,0 +1,25 @@
+#pragma once
+
+#include "MappedFileConfiguration.h"
+
+
+// Flattens a JSON document into keys like "zone.spawns[2].x".
+// Only scalar values are stored; null is stored as an empty string.
+class JSONConfiguration : public MappedFileConfiguration
+{
+public:
+	using Ptr = AutoPtr<JSONConfiguration>;
+	friend Ptr;
+
+	JSONConfiguration();
+	JSONConfiguration(const std::string& path);
+
+protected:
+	MappedFileConfiguration* create() const;
+	void parse(const char* begin, const char* end);
+
+	~JSONConfiguration();
+
+private:
+	class Parser;
+};
@@ -2,81 +2,151 @@
 #include "BaseException.h"
 #include <set>
 
-LayeredConfiguration::LayeredConfiguration()
+LayeredConfiguration::LayeredConfiguration() :
+	_indexVersion(0)
 {
 }
 
 
 LayeredConfiguration::~LayeredConfiguration()
 {
+	for (auto& conf : _configs)
+	{
+		unsubscribe(conf);
+	}
 }
 
 
-void LayeredConfiguration::add(IConfiguration::Ptr pConfig)
+void LayeredConfiguration::add(Configuration::Ptr pConfig)
 {
 	add(pConfig, highest(), false);
 }
 
 
-void LayeredConfiguration::add(IConfiguration::Ptr pConfig, const std::string& label)
+void LayeredConfiguration::add(Configuration::Ptr pConfig, const std::string& label)
 {
 	add(pConfig, label, highest(), false);
 }
 
 
-void LayeredConfiguration::add(IConfiguration::Ptr pConfig, int priority)
+void LayeredConfiguration::add(Configuration::Ptr pConfig, int priority)
 {
 	add(pConfig, priority, false);
 }
 
 
-void LayeredConfiguration::add(IConfiguration::Ptr pConfig, const std::string& label, int priority)
+void LayeredConfiguration::add(Configuration::Ptr pConfig, const std::string& label, int priority)
 {
 	add(pConfig, label, priority, false);
 }
 
 
-void LayeredConfiguration::addWriteable(IConfiguration::Ptr pConfig, int priority)
+void LayeredConfiguration::addWriteable(Configuration::Ptr pConfig, int priority)
 {
 	add(pConfig, priority, true);
 }
 
 
-void LayeredConfiguration::add(IConfiguration::Ptr pConfig, int priority, bool writeable)
+void LayeredConfiguration::add(Configuration::Ptr pConfig, int priority, bool writeable)
 {
 	add(pConfig, std::string(), priority, writeable);
 }
 
 
-void LayeredConfiguration::add(IConfiguration::Ptr pConfig, const std::string& label, int priority, bool writeable)
+void LayeredConfiguration::add(Configuration::Ptr pConfig, const std::string& label, int priority, bool writeable)
 {
 	ConfigItem item;
 	item.pConfig = pConfig;
 	item.priority = priority;
 	item.writeable = writeable;
 	item.label = label;
+	subscribe(item);
+
+	// Snapshot under our lock: a change event that fires meanwhile waits
+	// for it and is applied on top of the snapshot, not overwritten by it.
+	std::unique_lock<std::mutex> lock(mutex());
+
+	Entries range;
+	{
+		std::unique_lock<std::mutex> layerLock(pConfig->mutex());
+		pConfig->entries(range);
+	}
 
 	ConfigList::iterator it = _configs.begin();
 	while (it != _configs.end() && it->priority < priority) ++it;
 	_configs.insert(it, item);
+
+	// Layers with equal priority are inserted in front of the existing
+	// ones, so the new layer wins ties.
+	for (auto& entry : range)
+	{
+		Index::iterator itIndex = _index.find(entry.first);
+		if (itIndex == _index.end())
+		{
+			IndexEntry& indexEntry = _index[entry.first];
+			indexEntry.value.swap(entry.second);
+			indexEntry.priority = priority;
+			indexEntry.pConfig = pConfig.get();
+		}
+		else if (priority <= itIndex->second.priority)
+		{
+			itIndex->second.value.swap(entry.second);
+			itIndex->second.priority = priority;
+			itIndex->second.pConfig = pConfig.get();
+		}
+	}
+	++_indexVersion;
+	invalidateAll();
 }
 
 
-void LayeredConfiguration::removeConfiguration(IConfiguration::Ptr pConfig)
+void LayeredConfiguration::removeConfiguration(Configuration::Ptr pConfig)
 {
-	for (ConfigList::iterator it = _configs.begin(); it != _configs.end(); ++it)
 	{
-		if (it->pConfig == pConfig)
-		{
-			_configs.erase(it);
-			break;
-		}
+		std::unique_lock<std::mutex> lock(mutex());
+
+		ConfigList::iterator it = _configs.begin();
+		while (it != _configs.end() && it->pConfig != pConfig) ++it;
+		if (it == _configs.end()) return;
+		unsubscribe(*it);
+		_configs.erase(it);
+	}
+	rebuildIndex();
+}
+
+
+bool LayeredConfiguration::replaceConfiguration(Configuration::Ptr pOld, Configuration::Ptr pNew)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex());
+
+		ConfigList::iterator it = _configs.begin();
+		while (it != _configs.end() && it->pConfig != pOld) ++it;
+		if (it == _configs.end()) return false;
+		unsubscribe(*it);
+		it->pConfig = pNew;
+		subscribe(*it);
+	}
+	rebuildIndex();
+	return true;
+}
+
+
+void LayeredConfiguration::configurations(std::vector<Configuration::Ptr>& configs) const
+{
+	std::unique_lock<std::mutex> lock(mutex());
+
+	for (const auto& conf : _configs)
+	{
+		configs.push_back(conf.pConfig);
 	}
 }
 
 
-IConfiguration::Ptr LayeredConfiguration::find(const std::string& label) const
+Configuration::Ptr LayeredConfiguration::find(const std::string& label) const
 {
+	std::unique_lock<std::mutex> lock(mutex());
+
 	for (const auto& conf : _configs)
 	{
 		if (conf.label == label) return conf.pConfig;
@@ -87,11 +157,13 @@ IConfiguration::Ptr LayeredConfiguration::find(const std::string& label) const
 
 bool LayeredConfiguration::getRaw(const std::string& key, std::string& value) const
 {
-	for (const auto& conf : _configs)
+	Index::const_iterator it = _index.find(key);
+	if (it != _index.end())
 	{
-		if (conf.pConfig->getRaw(key, value)) return true;
+		value = it->second.value;
+		return true;
 	}
-	return false;
+	else return false;
 }
 
 
@@ -101,7 +173,12 @@ void LayeredConfiguration::setRaw(const std::string& key, const std::string& val
 	{
 		if (conf.writeable)
 		{
-			conf.pConfig->setRaw(key, value);
+			{
+				std::unique_lock<std::mutex> layerLock(conf.pConfig->mutex());
+				conf.pConfig->setRaw(key, value);
+				conf.pConfig->invalidate(key);
+			}
+			updateIndex(key);
 			return;
 		}
 	}
@@ -128,13 +205,28 @@ void LayeredConfiguration::enumerate(const std::string& key, Keys& range) const
 }
 
 
+void LayeredConfiguration::entries(Entries& range) const
+{
+	range.reserve(range.size() + _index.size());
+	for (const auto& p : _index)
+	{
+		range.push_back(Entry(p.first, p.second.value));
+	}
+}
+
+
 void LayeredConfiguration::removeRaw(const std::string& key)
 {
 	for (auto& conf : _configs)
 	{
 		if (conf.writeable)
 		{
-			conf.pConfig->remove(key);
+			{
+				std::unique_lock<std::mutex> layerLock(conf.pConfig->mutex());
+				conf.pConfig->removeRaw(key);
+				conf.pConfig->invalidateSubtree(key);
+			}
+			updateIndexSubtree(key);
 			return;
 		}
 	}
@@ -157,3 +249,148 @@ int LayeredConfiguration::highest() const
 	else
 		return _configs.back().priority + 1;
 }
+
+
+void LayeredConfiguration::subscribe(ConfigItem& item)
+{
+	item.changedId = item.pConfig->propertyChanged.add([this](const void*, const KeyValue& kv)
+		{
+			onLayerChanged(kv.key());
+		});
+	item.removedId = item.pConfig->propertyRemoved.add([this](const void*, const std::string& key)
+		{
+			onLayerRemoved(key);
+		});
+	item.resetId = item.pConfig->propertiesReset.add([this](const void*, const UInt32&)
+		{
+			onLayerReset();
+		});
+}
+
+
+void LayeredConfiguration::unsubscribe(ConfigItem& item)
+{
+	item.pConfig->propertyChanged.remove(item.changedId);
+	item.pConfig->propertyRemoved.remove(item.removedId);
+	item.pConfig->propertiesReset.remove(item.resetId);
+}
+
+
+void LayeredConfiguration::onLayerChanged(const std::string& key)
+{
+	std::unique_lock<std::mutex> lock(mutex());
+
+	updateIndex(key);
+	invalidate(key);
+}
+
+
+void LayeredConfiguration::onLayerRemoved(const std::string& key)
+{
+	std::unique_lock<std::mutex> lock(mutex());
+
+	updateIndexSubtree(key);
+	invalidateSubtree(key);
+}
+
+
+void LayeredConfiguration::onLayerReset()
+{
+	rebuildIndex();
+}
+
+
+void LayeredConfiguration::updateIndex(const std::string& key)
+{
+	std::string value;
+	for (const auto& conf : _configs)
+	{
+		bool found;
+		{
+			std::unique_lock<std::mutex> layerLock(conf.pConfig->mutex());
+			found = conf.pConfig->getRaw(key, value);
+		}
+		if (found)
+		{
+			IndexEntry& entry = _index[key];
+			entry.value.swap(value);
+			entry.priority = conf.priority;
+			entry.pConfig = conf.pConfig.get();
+			++_indexVersion;
+			return;
+		}
+	}
+	_index.erase(key);
+	++_indexVersion;
+}
+
+
+void LayeredConfiguration::updateIndexSubtree(const std::string& key)
+{
+	std::string prefix = key + '.';
+	Keys stale;
+	for (const auto& p : _index)
+	{
+		if (p.first == key || p.first.compare(0, prefix.size(), prefix) == 0)
+			stale.push_back(p.first);
+	}
+	for (const auto& k : stale)
+	{
+		updateIndex(k);
+	}
+}
+
+
+// Merges the layers into a fresh index without holding the lock, so a
+// reload costs one pass over each layer instead of a layer walk per key,
+// and readers keep using the old index meanwhile. The new index is only
+// swapped in if nothing touched the old one while it was built; after a
+// couple of lost races it is built under the lock.
+void LayeredConfiguration::rebuildIndex()
+{
+	for (int attempt = 0; ; ++attempt)
+	{
+		Index index;
+		std::unique_lock<std::mutex> lock(mutex());
+		if (attempt < 3)
+		{
+			ConfigList configs(_configs);
+			UInt32 version = _indexVersion;
+			lock.unlock();
+			buildIndex(configs, index);
+			lock.lock();
+			if (version != _indexVersion) continue;
+		}
+		else buildIndex(_configs, index);
+
+		_index.swap(index);
+		++_indexVersion;
+		invalidateAll();
+		return;
+	}
+}
+
+
+void LayeredConfiguration::buildIndex(const ConfigList& configs, Index& index)
+{
+	for (const auto& conf : configs)
+	{
+		Entries range;
+		{
+			std::unique_lock<std::mutex> layerLock(conf.pConfig->mutex());
+			conf.pConfig->entries(range);
+		}
+		if (index.empty()) index.reserve(range.size());
+		for (auto& entry : range)
+		{
+			// layers are sorted by priority, so the first one to provide a
+			// key wins
+			Index::iterator it = index.find(entry.first);
+			if (it != index.end()) continue;
+			IndexEntry& indexEntry = index[entry.first];
+			indexEntry.value.swap(entry.second);
+			indexEntry.priority = conf.priority;
+			indexEntry.pConfig = conf.pConfig.get();
+		}
+	}
+}
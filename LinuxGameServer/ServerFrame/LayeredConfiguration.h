@@ -4,8 +4,9 @@
 #include "AutoPtr.h"
 #include <list>
 #include <memory>
+#include <unordered_map>
 
-class LayeredConfiguration : public IConfiguration
+class LayeredConfiguration : public Configuration
 {
 public:
 	using Ptr = AutoPtr<LayeredConfiguration>;
@@ -13,37 +14,52 @@ public:
 
 	LayeredConfiguration();
 
-	void add(IConfiguration::Ptr pConfig);
+	void add(Configuration::Ptr pConfig);
 
-	void add(IConfiguration::Ptr pConfig, const std::string& label);
+	void add(Configuration::Ptr pConfig, const std::string& label);
 
-	void add(IConfiguration::Ptr pConfig, int priority);
+	void add(Configuration::Ptr pConfig, int priority);
 
-	void add(IConfiguration::Ptr pConfig, const std::string& label, int priority);
+	void add(Configuration::Ptr pConfig, const std::string& label, int priority);
 
-	void add(IConfiguration::Ptr pConfig, int priority, bool writeable);
+	void add(Configuration::Ptr pConfig, int priority, bool writeable);
 
-	void add(IConfiguration::Ptr pConfig, const std::string& label, int priority, bool writeable);
+	void add(Configuration::Ptr pConfig, const std::string& label, int priority, bool writeable);
 
-	void addWriteable(IConfiguration::Ptr pConfig, int priority);
+	void addWriteable(Configuration::Ptr pConfig, int priority);
 
-	IConfiguration::Ptr find(const std::string& label) const;
+	Configuration::Ptr find(const std::string& label) const;
 
-	void removeConfiguration(IConfiguration::Ptr pConfig);
+	void removeConfiguration(Configuration::Ptr pConfig);
+
+	bool replaceConfiguration(Configuration::Ptr pOld, Configuration::Ptr pNew);
+
+	void configurations(std::vector<Configuration::Ptr>& configs) const;
 
 protected:
 	struct ConfigItem
 	{
-		typedef IConfiguration::Ptr ACPtr;
+		typedef Configuration::Ptr ACPtr;
 		ACPtr       pConfig;
 		int         priority;
 		bool        writeable;
 		std::string label;
+		int         changedId;
+		int         removedId;
+		int         resetId;
+	};
+
+	struct IndexEntry
+	{
+		std::string          value;
+		int                  priority;
+		const Configuration* pConfig;
 	};
 
 	bool getRaw(const std::string& key, std::string& value) const;
 	void setRaw(const std::string& key, const std::string& value);
 	void enumerate(const std::string& key, Keys& range) const;
+	void entries(Entries& range) const;
 	void removeRaw(const std::string& key);
 
 	int lowest() const;
@@ -57,7 +73,21 @@ private:
 	LayeredConfiguration& operator = (const LayeredConfiguration&);
 
 	typedef std::list<ConfigItem> ConfigList;
+	typedef std::unordered_map<std::string, IndexEntry> Index;
+
+	void subscribe(ConfigItem& item);
+	void unsubscribe(ConfigItem& item);
+	void onLayerChanged(const std::string& key);
+	void onLayerRemoved(const std::string& key);
+	void onLayerReset();
+
+	void updateIndex(const std::string& key);
+	void updateIndexSubtree(const std::string& key);
+	void rebuildIndex();
+	static void buildIndex(const ConfigList& configs, Index& index);
 
 	ConfigList _configs;
+	Index      _index;
+	UInt32     _indexVersion;	///< bumped on every index change, under the lock
 };
 
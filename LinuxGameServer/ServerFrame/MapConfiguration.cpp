@@ -0,0 +1,104 @@
+#include "MapConfiguration.h"
+#include <set>
+
+
+MapConfiguration::MapConfiguration()
+{
+}
+
+
+MapConfiguration::~MapConfiguration()
+{
+}
+
+
+void MapConfiguration::clear()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex());
+
+		_map.clear();
+		invalidateAll();
+	}
+	notifyReset();
+}
+
+
+bool MapConfiguration::getRaw(const std::string& key, std::string& value) const
+{
+	StringMap::const_iterator it = _map.find(key);
+	if (it != _map.end())
+	{
+		value = it->second;
+		return true;
+	}
+	else return false;
+}
+
+
+void MapConfiguration::setRaw(const std::string& key, const std::string& value)
+{
+	_map[key] = value;
+}
+
+
+void MapConfiguration::enumerate(const std::string& key, Keys& range) const
+{
+	std::set<std::string> keys;
+	std::string prefix = key;
+	if (!prefix.empty()) prefix += '.';
+	std::string::size_type psize = prefix.size();
+	for (const auto& p : _map)
+	{
+		if (p.first.compare(0, psize, prefix) == 0)
+		{
+			std::string subKey;
+			std::string::size_type pos = p.first.find('.', psize);
+			if (pos == std::string::npos)
+				subKey = p.first.substr(psize);
+			else
+				subKey = p.first.substr(psize, pos - psize);
+			if (keys.find(subKey) == keys.end())
+			{
+				range.push_back(subKey);
+				keys.insert(subKey);
+			}
+		}
+	}
+}
+
+
+void MapConfiguration::entries(Entries& range) const
+{
+	range.insert(range.end(), _map.begin(), _map.end());
+}
+
+
+void MapConfiguration::removeRaw(const std::string& key)
+{
+	std::string prefix = key;
+	if (!prefix.empty()) prefix += '.';
+	std::string::size_type psize = prefix.size();
+	StringMap::iterator it = _map.begin();
+	StringMap::iterator itCur;
+	while (it != _map.end())
+	{
+		itCur = it++;
+		if ((itCur->first == key) || (itCur->first.compare(0, psize, prefix) == 0))
+		{
+			_map.erase(itCur);
+		}
+	}
+}
+
+
+MapConfiguration::iterator MapConfiguration::begin() const
+{
+	return _map.begin();
+}
+
+
+MapConfiguration::iterator MapConfiguration::end() const
+{
+	return _map.end();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Configuration.h"
+#include <map>
+
+
+class MapConfiguration : public Configuration
+{
+public:
+	using Ptr = AutoPtr<MapConfiguration>;
+	friend Ptr;
+
+	MapConfiguration();
+
+	void clear();
+
+protected:
+	using StringMap = std::map<std::string, std::string>;
+	using iterator = StringMap::const_iterator;
+
+	bool getRaw(const std::string& key, std::string& value) const;
+	void setRaw(const std::string& key, const std::string& value);
+	void enumerate(const std::string& key, Keys& range) const;
+	void entries(Entries& range) const;
+	void removeRaw(const std::string& key);
+
+	iterator begin() const;
+	iterator end() const;
+
+	~MapConfiguration();
+
+private:
+	StringMap _map;
+};
@@ -0,0 +1,266 @@
+#include "MappedFileConfiguration.h"
+#include "BaseException.h"
+#include "NumberFormatter.h"
+#include "File.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <set>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+namespace
+{
+	void readFile(const std::string& path, std::unique_ptr<char[]>& contents, std::size_t& size)
+	{
+		int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd == -1) File::handleLastError(path);
+
+		struct stat st;
+		if (::fstat(fd, &st) == -1)
+		{
+			int err = errno;
+			::close(fd);
+			File::handleLastError(err, path);
+		}
+
+		// The file may grow or shrink while it is read; whatever read()
+		// returns up to end of file is the snapshot.
+		std::size_t capacity = static_cast<std::size_t>(st.st_size) + 1;
+		std::unique_ptr<char[]> buffer(new char[capacity]);
+		std::size_t length = 0;
+		for (;;)
+		{
+			if (length == capacity)
+			{
+				std::unique_ptr<char[]> larger(new char[capacity * 2]);
+				std::memcpy(larger.get(), buffer.get(), length);
+				buffer.swap(larger);
+				capacity *= 2;
+			}
+			ssize_t n = ::read(fd, buffer.get() + length, capacity - length);
+			if (n > 0)
+				length += static_cast<std::size_t>(n);
+			else if (n == 0)
+				break;
+			else if (errno != EINTR)
+			{
+				int err = errno;
+				::close(fd);
+				File::handleLastError(err, path);
+			}
+		}
+		::close(fd);
+		contents.swap(buffer);
+		size = length;
+	}
+}
+
+
+MappedFileConfiguration::StringPool::StringPool() :
+	_pos(0),
+	_avail(0)
+{
+}
+
+
+std::string_view MappedFileConfiguration::StringPool::add(std::string_view str)
+{
+	if (str.empty()) return std::string_view();
+
+	if (str.size() > BLOCK_SIZE / 4)
+	{
+		_blocks.emplace_back(new char[str.size()]);
+		std::memcpy(_blocks.back().get(), str.data(), str.size());
+		return std::string_view(_blocks.back().get(), str.size());
+	}
+	if (str.size() > _avail)
+	{
+		_blocks.emplace_back(new char[BLOCK_SIZE]);
+		_pos = _blocks.back().get();
+		_avail = BLOCK_SIZE;
+	}
+	std::memcpy(_pos, str.data(), str.size());
+	std::string_view result(_pos, str.size());
+	_pos += str.size();
+	_avail -= str.size();
+	return result;
+}
+
+
+void MappedFileConfiguration::StringPool::clear()
+{
+	_blocks.clear();
+	_pos = 0;
+	_avail = 0;
+}
+
+
+MappedFileConfiguration::MappedFileConfiguration() :
+	_mode(LOAD_COPY),
+	_begin(0)
+{
+}
+
+
+MappedFileConfiguration::~MappedFileConfiguration()
+{
+}
+
+
+void MappedFileConfiguration::load(const std::string& path, LoadMode mode)
+{
+	std::unique_ptr<SharedMemory> pMemory;
+	std::unique_ptr<char[]> pContents;
+	std::size_t size = 0;
+	if (mode == LOAD_MAP)
+	{
+		File file(path);
+		if (!file.exists())
+			throw FileNotFoundException(path);
+		pMemory.reset(new SharedMemory(file, SharedMemory::AM_READ));
+		size = pMemory->size();
+	}
+	else readFile(path, pContents, size);
+
+	try
+	{
+		std::unique_lock<std::mutex> lock(mutex());
+
+		_index.clear();
+		_pool.clear();
+		_path = path;
+		_mode = mode;
+		_pMemory.swap(pMemory);
+		_pContents.swap(pContents);
+		_begin = _pMemory ? _pMemory->begin() : _pContents.get();
+
+		const char* begin = _begin;
+		const char* end = begin + size;
+		_index.reserve(std::count(begin, end, '\n') + 1);
+		parse(begin, end);
+		invalidateAll();
+	}
+	catch (...)
+	{
+		// a syntax error leaves the keys parsed so far
+		{
+			std::unique_lock<std::mutex> lock(mutex());
+			invalidateAll();
+		}
+		notifyReset();
+		throw;
+	}
+	notifyReset();
+}
+
+
+MappedFileConfiguration::Ptr MappedFileConfiguration::reload() const
+{
+	Ptr pConfig(create());
+	pConfig->load(_path, _mode);
+	return pConfig;
+}
+
+
+void MappedFileConfiguration::diff(const MappedFileConfiguration& previous, Keys& changed, Keys& removed) const
+{
+	std::unique_lock<std::mutex> lock(previous.mutex());
+
+	for (const auto& p : _index)
+	{
+		Index::const_iterator it = previous._index.find(p.first);
+		if (it == previous._index.end() || it->second != p.second)
+			changed.push_back(std::string(p.first));
+	}
+	for (const auto& p : previous._index)
+	{
+		if (_index.find(p.first) == _index.end())
+			removed.push_back(std::string(p.first));
+	}
+}
+
+
+std::string_view MappedFileConfiguration::intern(std::string_view str)
+{
+	return _pool.add(str);
+}
+
+
+void MappedFileConfiguration::syntaxError(const char* msg, const char* pos) const
+{
+	int line = 1;
+	if (_begin && pos >= _begin)
+		line += static_cast<int>(std::count(_begin, pos, '\n'));
+	throw SyntaxException(msg, _path + ":" + NumberFormatter::format(line));
+}
+
+
+bool MappedFileConfiguration::getRaw(const std::string& key, std::string& value) const
+{
+	Index::const_iterator it = _index.find(key);
+	if (it != _index.end())
+	{
+		value.assign(it->second.data(), it->second.size());
+		return true;
+	}
+	else return false;
+}
+
+
+void MappedFileConfiguration::setRaw(const std::string& key, const std::string& value)
+{
+	Index::iterator it = _index.find(key);
+	if (it != _index.end())
+		it->second = intern(value);
+	else
+		_index.emplace(intern(key), intern(value));
+}
+
+
+void MappedFileConfiguration::enumerate(const std::string& key, Keys& range) const
+{
+	std::set<std::string_view> keys;
+	std::string prefix = key;
+	if (!prefix.empty()) prefix += '.';
+	std::string_view::size_type psize = prefix.size();
+	for (const auto& p : _index)
+	{
+		if (p.first.size() > psize && p.first.compare(0, psize, prefix) == 0)
+		{
+			std::string_view subKey = p.first.substr(psize);
+			keys.insert(subKey.substr(0, subKey.find('.')));
+		}
+	}
+	for (const auto& k : keys)
+	{
+		range.push_back(std::string(k));
+	}
+}
+
+
+void MappedFileConfiguration::entries(Entries& range) const
+{
+	range.reserve(range.size() + _index.size());
+	for (const auto& p : _index)
+	{
+		range.push_back(Entry(std::string(p.first), std::string(p.second)));
+	}
+}
+
+
+void MappedFileConfiguration::removeRaw(const std::string& key)
+{
+	std::string prefix = key + '.';
+	Index::iterator it = _index.begin();
+	while (it != _index.end())
+	{
+		if (it->first == key || it->first.compare(0, prefix.size(), prefix) == 0)
+			it = _index.erase(it);
+		else
+			++it;
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Configuration.h"
+#include "SharedMemory.h"
+
+#include <string_view>
+#include <unordered_map>
+#include <memory>
+
+
+// Base class for configurations loaded from a file without a copy per key.
+// Keys and values are views into the file contents, or into a string pool
+// for the ones that had to be composed or unescaped, and are only copied on
+// access.
+//
+// By default load() reads the file into a buffer owned by the
+// configuration, so a loaded configuration never changes once parsed.
+// LOAD_MAP memory maps the file instead, which saves the copy for large
+// files but is only safe for immutable ones: the mapping is shared with
+// the page cache, so an in-place edit changes values under the views and
+// truncating the file raises SIGBUS. reload() keeps the mode.
+class MappedFileConfiguration : public Configuration
+{
+public:
+	using Ptr = AutoPtr<MappedFileConfiguration>;
+	friend Ptr;
+
+	enum LoadMode
+	{
+		LOAD_COPY,
+		LOAD_MAP
+	};
+
+	void load(const std::string& path, LoadMode mode = LOAD_COPY);
+
+	Ptr reload() const;
+
+	void diff(const MappedFileConfiguration& previous, Keys& changed, Keys& removed) const;
+
+	const std::string& path() const;
+
+	std::size_t size() const;
+
+protected:
+	using Index = std::unordered_map<std::string_view, std::string_view>;
+
+	MappedFileConfiguration();
+
+	virtual MappedFileConfiguration* create() const = 0;
+	virtual void parse(const char* begin, const char* end) = 0;
+
+	void store(std::string_view key, std::string_view value);
+	std::string_view intern(std::string_view str);
+
+	[[noreturn]] void syntaxError(const char* msg, const char* pos) const;
+
+	bool getRaw(const std::string& key, std::string& value) const;
+	void setRaw(const std::string& key, const std::string& value);
+	void enumerate(const std::string& key, Keys& range) const;
+	void entries(Entries& range) const;
+	void removeRaw(const std::string& key);
+
+	~MappedFileConfiguration();
+
+private:
+	class StringPool
+	{
+	public:
+		StringPool();
+
+		std::string_view add(std::string_view str);
+		void clear();
+
+	private:
+		enum
+		{
+			BLOCK_SIZE = 64 * 1024
+		};
+
+		std::vector<std::unique_ptr<char[]>> _blocks;
+		char*       _pos;
+		std::size_t _avail;
+	};
+
+	std::string                   _path;
+	LoadMode                      _mode;
+	std::unique_ptr<SharedMemory> _pMemory;
+	std::unique_ptr<char[]>       _pContents;
+	const char*                   _begin;
+	Index                         _index;
+	StringPool                    _pool;
+};
+
+
+inline const std::string& MappedFileConfiguration::path() const
+{
+	return _path;
+}
+
+
+inline std::size_t MappedFileConfiguration::size() const
+{
+	return _index.size();
+}
+
+
+inline void MappedFileConfiguration::store(std::string_view key, std::string_view value)
+{
+	_index[key] = value;
+}
@@ -0,0 +1,136 @@
+#include "PropertyFileConfiguration.h"
+
+
+namespace
+{
+	inline bool isBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\f';
+	}
+
+	inline bool isSpace(char c)
+	{
+		return isBlank(c) || c == '\n' || c == '\r';
+	}
+
+	const char* skipLine(const char* it, const char* end)
+	{
+		while (it != end && *it != '\n' && *it != '\r') ++it;
+		return it;
+	}
+
+	void unescape(const char* it, const char* end, std::string& result)
+	{
+		result.clear();
+		while (it != end)
+		{
+			char c = *it++;
+			if (c == '\\' && it != end)
+			{
+				c = *it++;
+				switch (c)
+				{
+				case 't': result += '\t'; break;
+				case 'r': result += '\r'; break;
+				case 'n': result += '\n'; break;
+				case 'f': result += '\f'; break;
+				case '\r':
+					if (it != end && *it == '\n') ++it;
+					// fallthrough
+				case '\n':
+					while (it != end && isBlank(*it)) ++it;
+					break;
+				default:
+					result += c;
+					break;
+				}
+			}
+			else result += c;
+		}
+	}
+}
+
+
+PropertyFileConfiguration::PropertyFileConfiguration()
+{
+}
+
+
+PropertyFileConfiguration::PropertyFileConfiguration(const std::string& path)
+{
+	load(path);
+}
+
+
+PropertyFileConfiguration::~PropertyFileConfiguration()
+{
+}
+
+
+MappedFileConfiguration* PropertyFileConfiguration::create() const
+{
+	return new PropertyFileConfiguration;
+}
+
+
+void PropertyFileConfiguration::parse(const char* begin, const char* end)
+{
+	const char* it = begin;
+	while (it != end)
+	{
+		while (it != end && isSpace(*it)) ++it;
+		if (it == end) break;
+
+		if (*it == '#' || *it == '!')
+		{
+			it = skipLine(it, end);
+			continue;
+		}
+
+		std::string_view key = readToken(it, end, true);
+		std::string_view value;
+		if (it != end && (*it == '=' || *it == ':'))
+		{
+			++it;
+			while (it != end && isBlank(*it)) ++it;
+			value = readToken(it, end, false);
+		}
+		store(key, value);
+	}
+}
+
+
+std::string_view PropertyFileConfiguration::readToken(const char*& it, const char* end, bool isKey)
+{
+	const char* begin = it;
+	bool escaped = false;
+	while (it != end)
+	{
+		char c = *it;
+		if (c == '\\')
+		{
+			escaped = true;
+			if (++it == end) break;
+			if (*it == '\r' && it + 1 != end && it[1] == '\n') ++it;
+			++it;
+		}
+		else if (c == '\n' || c == '\r' || (isKey && (c == '=' || c == ':')))
+		{
+			break;
+		}
+		else ++it;
+	}
+
+	if (escaped)
+	{
+		unescape(begin, it, _scratch);
+		std::string::size_type n = _scratch.size();
+		while (n > 0 && isSpace(_scratch[n - 1])) --n;
+		_scratch.resize(n);
+		return intern(_scratch);
+	}
+
+	const char* last = it;
+	while (last != begin && isBlank(last[-1])) --last;
+	return std::string_view(begin, last - begin);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "MappedFileConfiguration.h"
+
+
+class PropertyFileConfiguration : public MappedFileConfiguration
+{
+public:
+	using Ptr = AutoPtr<PropertyFileConfiguration>;
+	friend Ptr;
+
+	PropertyFileConfiguration();
+	PropertyFileConfiguration(const std::string& path);
+
+protected:
+	MappedFileConfiguration* create() const;
+	void parse(const char* begin, const char* end);
+
+	~PropertyFileConfiguration();
+
+private:
+	std::string_view readToken(const char*& it, const char* end, bool isKey);
+
+	std::string _scratch;
+};
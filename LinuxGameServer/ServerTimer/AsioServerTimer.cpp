@@ -1,5 +1,6 @@
 
 #include "AsioServerTimer.h"
+#include "Clock.h"
 
 CAsioServerTimer::CAsioServerTimer()
 	: _thread(nullptr)
@@ -183,6 +184,7 @@ void CAsioServerTimer::onTimeOut(boost::system::error_code ec, ServerTimerItemPt
 		pm->t->async_wait(boost::bind(&CAsioServerTimer::onTimeOut, this, boost::asio::placeholders::error, pm));
 	}
 
+	Clock::tick();
 	if (_listener != nullptr)
 	{
 		_listener->OnTimer(iTimerID, iElapse);
@@ -9,6 +9,7 @@
 #include <atomic>
 #include <string.h>
 #include "Event.h"
+#include "ObjectPool.h"
 
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
@@ -40,7 +41,8 @@ class CAsioServerTimer : public IServerTimer
 		}
 	};
 	typedef ServerTimerItem* ServerTimerItemPtr;
-	typedef std::unordered_map<unsigned int, ServerTimerItemPtr> ServerTimerItemPtrMap;
+	typedef std::unordered_map<unsigned int, ServerTimerItemPtr, std::hash<unsigned int>, std::equal_to<unsigned int>,
+		PoolAllocator<std::pair<const unsigned int, ServerTimerItemPtr> > > ServerTimerItemPtrMap;
 	typedef std::vector<ServerTimerItemPtr> ServerTimerItemPtrArray;
 
 public:
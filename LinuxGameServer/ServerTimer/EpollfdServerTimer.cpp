@@ -1,5 +1,6 @@
 
 #include "EpollfdServerTimer.h"
+#include "Clock.h"
 
 #include <stdlib.h>
 #include <cstdio>
@@ -276,6 +277,7 @@ void CEpollfdServerTimer::onThread()
 			printf("epoll_wait() failed: errno=%d\n", errno);
 			break;
 		}
+		if (fireEvents > 0) Clock::tick();
 
 		for (int i = 0; i < fireEvents; ++i)
 		{
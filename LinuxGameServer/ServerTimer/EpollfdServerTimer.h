@@ -10,6 +10,7 @@
 #include <atomic>
 #include <string.h>
 #include "Event.h"
+#include "ObjectPool.h"
 
 
 class CEpollfdServerTimer : public IServerTimer
@@ -38,7 +39,8 @@ public:
 		}
 	};
 	typedef ServerTimerItem* ServerTimerItemPtr;
-	typedef std::unordered_map<unsigned int, ServerTimerItemPtr> ServerTimerItemPtrMap;
+	typedef std::unordered_map<unsigned int, ServerTimerItemPtr, std::hash<unsigned int>, std::equal_to<unsigned int>,
+		PoolAllocator<std::pair<const unsigned int, ServerTimerItemPtr> > > ServerTimerItemPtrMap;
 	typedef std::vector<ServerTimerItemPtr> ServerTimerItemPtrArray;
 
 public:
@@ -1,5 +1,6 @@
 
 #include "LibeventServerTimer.h"
+#include "Clock.h"
 
 #include <sys/types.h>
 #include <event2/event-config.h>
@@ -246,6 +247,7 @@ void CLibeventServerTimer::onTimeOut(unsigned int iTimerID, unsigned int iElapse
 		KillTimer(iTimerID);
 	}
 
+	Clock::tick();
 	if (_listener != nullptr)
 	{
 		_listener->OnTimer(iTimerID, iElapse);
@@ -3,6 +3,7 @@
 
 #include "IServerTimer.h"
 #include "Event.h"
+#include "ObjectPool.h"
 
 #include <thread>
 #include <mutex>
@@ -44,7 +45,8 @@ class CLibeventServerTimer : public IServerTimer
 		}
 	};
 	typedef ServerTimerItem* ServerTimerItemPtr;
-	typedef std::unordered_map<unsigned int, ServerTimerItemPtr> ServerTimerItemPtrMap;
+	typedef std::unordered_map<unsigned int, ServerTimerItemPtr, std::hash<unsigned int>, std::equal_to<unsigned int>,
+		PoolAllocator<std::pair<const unsigned int, ServerTimerItemPtr> > > ServerTimerItemPtrMap;
 	typedef std::vector<ServerTimerItemPtr> ServerTimerItemPtrArray;
 
 public:
@@ -1,15 +1,12 @@
 
 #include "SleepServerTimer.h"
 #include <unistd.h>
-#include <sys/time.h>
+#include "Clock.h"
 #include <assert.h>
 
 long long GetSysMilliseconds()
 {
-	struct timeval tv;
-	::gettimeofday(&tv, NULL);
-
-	return tv.tv_sec * 1000 + tv.tv_usec / 1000;
+	return Clock::monotonicNanoseconds() / 1000000;
 }
 
 unsigned int CSleepServerTimer::s_iResolution = 100;
@@ -49,9 +46,7 @@ void CSleepServerTimer::SetTimer(unsigned int iTimerID, unsigned int iElapse, bo
 		iElapse = s_iResolution;
 	}
 
-	struct timeval tv;
-	::gettimeofday(&tv, nullptr);
-	long long iMS = tv.tv_sec * 1000 + tv.tv_usec / 1000;
+	long long iMS = GetSysMilliseconds();
 
 	ServerTimerItemPtr item = nullptr;
 	{
@@ -186,6 +181,7 @@ void CSleepServerTimer::onThread()
 
 		temps.clear();
 		currTime = GetSysMilliseconds() / s_iResolution * s_iResolution;
+		Clock::tick();
 
 		{
 			std::lock_guard<std::mutex> lk(_mutex);
@@ -8,6 +8,7 @@
 #include <vector>
 #include <atomic>
 #include "Event.h"
+#include "ObjectPool.h"
 
 
 class CSleepServerTimer : public IServerTimer
@@ -32,7 +33,8 @@ public:
 		}
 	};
 	typedef ServerTimerItem* ServerTimerItemPtr;
-	typedef std::unordered_map<unsigned int, ServerTimerItemPtr> ServerTimerItemPtrMap;
+	typedef std::unordered_map<unsigned int, ServerTimerItemPtr, std::hash<unsigned int>, std::equal_to<unsigned int>,
+		PoolAllocator<std::pair<const unsigned int, ServerTimerItemPtr> > > ServerTimerItemPtrMap;
 	typedef std::vector<ServerTimerItemPtr> ServerTimerItemPtrArray;
 
 public:
@@ -1,13 +1,12 @@
 ﻿#include <cstdio>
 #include <iostream>
 #include <time.h>
-#include <thread>
-#include <unistd.h>
-#include <condition_variable>
+#include <atomic>
 
 #include "Application.h"
 #include "ServerApplication.h"
 #include "DateTimeFormatter.h"
+#include "Thread.h"
 
 class SampleServer : public ServerApplication
 {
@@ -42,14 +41,15 @@ protected:
 	{
 		static std::atomic_bool state = { false };
 
-		std::thread trd{ [] {
+		Thread trd("busy");
+		trd.startFunc([] {
 			Application& app = Application::instance();
 			while (state.load())
 			{
-				sleep(5000);
+				Thread::sleep(5000);
 				Application::instance().logger().information("busy doing nothing... " + DateTimeFormatter::format(app.uptime()));
 			}
-		} };
+		});
 
 		waitForTerminationRequest();
 